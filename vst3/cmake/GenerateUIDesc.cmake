@@ -6,7 +6,184 @@ if(NOT DEFINED PROJECT_VERSION)
   set(PROJECT_VERSION "0.0.0")
 endif()
 
+if(NOT DEFINED BEAT_MAX_LANES)
+  set(BEAT_MAX_LANES 8)
+endif()
+
 string(TIMESTAMP BUILD_TIME "%Y-%m-%d %H:%M")
 set(BEAT_BUILD_STAMP "${PROJECT_VERSION} (${BUILD_TIME})")
 
-configure_file("${INPUT}" "${OUTPUT}" @ONLY)
+# The template is laid out for 8 lanes: one row of Beat Select buttons and one
+# row of Mute/Solo/Activity buttons, 60 px per lane. Other lane counts keep
+# lane 1's buttons as prototypes, lay the lanes out 8 to a row (each further
+# row of lanes pushes the rest of the editor down), and rebuild the control
+# tags from the same parameter layout as BeatIDs.h.
+set(LANES_PER_ROW 8)
+set(LANE_COLUMN_WIDTH 60)
+set(LANE_ROW_HEIGHT 56)
+# Views at or below this y belong to the controls under the lane strip.
+set(LANE_STRIP_BOTTOM 110)
+
+file(READ "${INPUT}" CONTENTS)
+
+# The template text of the button bound to a control tag.
+function(beat_uidesc_element out tag)
+  string(REGEX MATCH "\"CTextButton\": {[^{}]*{[^{}]*\"control-tag\": \"${tag}\",[^{}]*}[^{}]*}" element "${CONTENTS}")
+  set(${out} "${element}" PARENT_SCOPE)
+endfunction()
+
+# Replaces the template text from the first to the last of a run of elements.
+function(beat_uidesc_replace_run first last replacement)
+  string(FIND "${CONTENTS}" "${first}" begin)
+  string(FIND "${CONTENTS}" "${last}" end)
+  if(begin LESS 0 OR end LESS begin)
+    message(FATAL_ERROR "GenerateUIDesc.cmake: lane buttons not found in ${INPUT}")
+  endif()
+  string(LENGTH "${last}" length)
+  math(EXPR end "${end} + ${length}")
+  string(SUBSTRING "${CONTENTS}" 0 ${begin} head)
+  string(SUBSTRING "${CONTENTS}" ${end} -1 tail)
+  set(CONTENTS "${head}${replacement}${tail}" PARENT_SCOPE)
+endfunction()
+
+# Moves an element's origin by (dx, dy) relative to its prototype's.
+function(beat_uidesc_move out element dx dy)
+  string(REGEX MATCH "\"origin\": \"([0-9]+), ([0-9]+)\"" origin "${element}")
+  math(EXPR x "${CMAKE_MATCH_1} + ${dx}")
+  math(EXPR y "${CMAKE_MATCH_2} + ${dy}")
+  string(REPLACE "${origin}" "\"origin\": \"${x}, ${y}\"" element "${element}")
+  set(${out} "${element}" PARENT_SCOPE)
+endfunction()
+
+if(NOT BEAT_MAX_LANES EQUAL 8)
+  math(EXPR lane_rows "(${BEAT_MAX_LANES} + ${LANES_PER_ROW} - 1) / ${LANES_PER_ROW}")
+  math(EXPR extra_height "(${lane_rows} - 1) * ${LANE_ROW_HEIGHT}")
+
+  # Push everything under the lane strip down and grow the editor to fit.
+  if(extra_height GREATER 0)
+    set(moved "")
+    set(rest "${CONTENTS}")
+    string(REGEX MATCH "\"origin\": \"([0-9]+), ([0-9]+)\"" origin "${rest}")
+    while(origin)
+      set(x ${CMAKE_MATCH_1})
+      set(y ${CMAKE_MATCH_2})
+      string(FIND "${rest}" "${origin}" at)
+      string(LENGTH "${origin}" length)
+      math(EXPR after "${at} + ${length}")
+      string(SUBSTRING "${rest}" 0 ${at} head)
+      string(SUBSTRING "${rest}" ${after} -1 rest)
+      if(y GREATER_EQUAL LANE_STRIP_BOTTOM)
+        math(EXPR y "${y} + ${extra_height}")
+      endif()
+      string(APPEND moved "${head}\"origin\": \"${x}, ${y}\"")
+      string(REGEX MATCH "\"origin\": \"([0-9]+), ([0-9]+)\"" origin "${rest}")
+    endwhile()
+    set(CONTENTS "${moved}${rest}")
+
+    foreach(size "500, 270" "500, 280")
+      string(REGEX MATCH "([0-9]+)$" height "${size}")
+      math(EXPR height "${height} + ${extra_height}")
+      string(REPLACE "\"size\": \"${size}\"" "\"size\": \"500, ${height}\"" CONTENTS "${CONTENTS}")
+    endforeach()
+    math(EXPR selector_height "20 + ${extra_height}")
+    string(REPLACE "\"size\": \"470, 20\"" "\"size\": \"470, ${selector_height}\"" CONTENTS "${CONTENTS}")
+  endif()
+
+  # Lane n's buttons, from lane 1's.
+  beat_uidesc_element(select_prototype "Root::BeatSelect1")
+  beat_uidesc_element(mute_prototype "Lane1::Mute")
+  beat_uidesc_element(solo_prototype "Lane1::Solo")
+  beat_uidesc_element(activity_prototype "Lane1::Activity")
+  string(REGEX MATCH "\n([\t]*)\"CTextButton\": {[^{}]*{[^{}]*\"control-tag\": \"Root::BeatSelect1\"" select_indent "${CONTENTS}")
+  set(select_separator ",\n${CMAKE_MATCH_1}")
+  string(REGEX MATCH "\n([\t]*)\"CTextButton\": {[^{}]*{[^{}]*\"control-tag\": \"Lane1::Mute\"" lane_indent "${CONTENTS}")
+  set(lane_separator ",\n${CMAKE_MATCH_1}")
+
+  set(select_buttons "")
+  set(lane_buttons "")
+  math(EXPR last_lane "${BEAT_MAX_LANES} - 1")
+  foreach(lane RANGE ${last_lane})
+    math(EXPR number "${lane} + 1")
+    math(EXPR dx "(${lane} % ${LANES_PER_ROW}) * ${LANE_COLUMN_WIDTH}")
+    math(EXPR dy "(${lane} / ${LANES_PER_ROW}) * ${LANE_ROW_HEIGHT}")
+    if(lane GREATER 0)
+      string(APPEND select_buttons "${select_separator}")
+      string(APPEND lane_buttons "${lane_separator}")
+    endif()
+
+    beat_uidesc_move(button "${select_prototype}" ${dx} ${dy})
+    string(REPLACE "\"Root::BeatSelect1\"" "\"Root::BeatSelect${number}\"" button "${button}")
+    string(REPLACE "\"title\": \"1\"" "\"title\": \"${number}\"" button "${button}")
+    string(APPEND select_buttons "${button}")
+
+    set(row "")
+    foreach(prototype "${mute_prototype}" "${solo_prototype}" "${activity_prototype}")
+      beat_uidesc_move(button "${prototype}" ${dx} ${dy})
+      string(REPLACE "\"Lane1::" "\"Lane${number}::" button "${button}")
+      if(row)
+        string(APPEND row "${lane_separator}")
+      endif()
+      string(APPEND row "${button}")
+    endforeach()
+    string(APPEND lane_buttons "${row}")
+  endforeach()
+
+  beat_uidesc_element(last_select "Root::BeatSelect8")
+  beat_uidesc_replace_run("${select_prototype}" "${last_select}" "${select_buttons}")
+  beat_uidesc_element(first_lane "Lane1::Mute")
+  beat_uidesc_element(last_lane_button "Lane8::Activity")
+  beat_uidesc_replace_run("${first_lane}" "${last_lane_button}" "${lane_buttons}")
+
+  # Control tags: the parameter IDs from BeatIDs.h for this lane count.
+  set(per_beat 7)
+  math(EXPR active_base "3 + ${BEAT_MAX_LANES} * ${per_beat}")
+  math(EXPR mute_base "${active_base} + ${per_beat}")
+  math(EXPR solo_base "${mute_base} + ${BEAT_MAX_LANES}")
+  math(EXPR activity_base "${solo_base} + ${BEAT_MAX_LANES}")
+  math(EXPR global_solo "${activity_base} + ${BEAT_MAX_LANES}")
+  # Slot of each generator parameter, in the editor's (alphabetical) order.
+  set(slot_names Bars Beats Loop Loud NoteIndex Octave Rotate)
+  set(slot_Bars 0)
+  set(slot_Loop 1)
+  set(slot_Beats 2)
+  set(slot_Rotate 3)
+  set(slot_NoteIndex 4)
+  set(slot_Octave 5)
+  set(slot_Loud 6)
+
+  set(tag_indent "\n\t\t\t")
+  set(tags "")
+  foreach(name IN LISTS slot_names)
+    math(EXPR id "${active_base} + ${slot_${name}}")
+    string(APPEND tags "${tag_indent}\"Active::${name}\": \"${id}\",")
+  endforeach()
+  foreach(lane RANGE ${last_lane})
+    math(EXPR number "${lane} + 1")
+    foreach(name IN LISTS slot_names)
+      math(EXPR id "3 + ${lane} * ${per_beat} + ${slot_${name}}")
+      string(APPEND tags "${tag_indent}\"Generator${number}::${name}\": \"${id}\",")
+    endforeach()
+  endforeach()
+  foreach(lane RANGE ${last_lane})
+    math(EXPR number "${lane} + 1")
+    math(EXPR activity "${activity_base} + ${lane}")
+    math(EXPR mute "${mute_base} + ${lane}")
+    math(EXPR solo "${solo_base} + ${lane}")
+    string(APPEND tags "${tag_indent}\"Lane${number}::Activity\": \"${activity}\",")
+    string(APPEND tags "${tag_indent}\"Lane${number}::Mute\": \"${mute}\",")
+    string(APPEND tags "${tag_indent}\"Lane${number}::Solo\": \"${solo}\",")
+  endforeach()
+  string(APPEND tags "${tag_indent}\"Root::BeatSelect\": \"1\",")
+  foreach(lane RANGE ${last_lane})
+    math(EXPR number "${lane} + 1")
+    math(EXPR id "1000 + ${lane}")
+    string(APPEND tags "${tag_indent}\"Root::BeatSelect${number}\": \"${id}\",")
+  endforeach()
+  string(APPEND tags "${tag_indent}\"Root::EffectEnabled\": \"0\",")
+  string(APPEND tags "${tag_indent}\"Root::GlobalSolo\": \"${global_solo}\",")
+  string(APPEND tags "${tag_indent}\"Root::Reset\": \"2\"\n\t\t")
+  string(REGEX REPLACE "\"control-tags\": {[^{}]*}" "\"control-tags\": {${tags}}" CONTENTS "${CONTENTS}")
+endif()
+
+string(CONFIGURE "${CONTENTS}" CONTENTS @ONLY)
+file(WRITE "${OUTPUT}" "${CONTENTS}")
@@ -9,6 +9,11 @@ endif()
 
 file(READ "${INPUT_BUNDLE}" CONTENTS)
 
+# GenerateUIDesc.cmake lays other lane counts out from the 8-lane template.
+if(NOT CONTENTS MATCHES "\"Root::BeatSelect8\"" OR CONTENTS MATCHES "\"Root::BeatSelect9\"")
+  message(FATAL_ERROR "ImportUIDesc: ${INPUT_BUNDLE} is not an 8-lane editor; import from a BEAT_MAX_LANES=8 build.")
+endif()
+
 # Restore the build stamp placeholder in the title.
 string(REGEX REPLACE "title=\"Beat MIDI Generator v[^\"]*\"" "title=\"Beat MIDI Generator v@BEAT_BUILD_STAMP@\"" CONTENTS "${CONTENTS}")
 
@@ -0,0 +1,35 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+#pragma once
+
+#include "BeatEngine.h"
+
+#include <atomic>
+
+namespace beatvst {
+
+// Lane lights handed from the audio thread to the editor without locks or host
+// parameter traffic. The processor publishes once per block and drains it when
+// the controller's UI timer asks (kBeatActivityPollMessage). Relaxed ordering
+// is enough: the two masks are only ever ORed together.
+struct BeatActivityChannel {
+    static_assert(std::atomic<BeatLaneMask>::is_always_lock_free, "lane mask must be a lock-free atomic");
+
+    std::atomic<BeatLaneMask> litLanes{0};  // lanes lit at the end of the last block
+    std::atomic<BeatLaneMask> hitLanes{0};  // lanes struck since the last drain
+
+    // Audio thread.
+    void clear() { litLanes.store(0, std::memory_order_relaxed); }
+    void publish(BeatLaneMask lit, BeatLaneMask hits) {
+        litLanes.store(lit, std::memory_order_relaxed);
+        if (hits != 0) hitLanes.fetch_or(hits, std::memory_order_relaxed);
+    }
+
+    // UI thread. Lanes to show lit: those lit now plus those struck since the
+    // last drain, so a hit shorter than the timer period still blinks.
+    BeatLaneMask drain() {
+        return litLanes.load(std::memory_order_relaxed) | hitLanes.exchange(0, std::memory_order_relaxed);
+    }
+};
+
+} // namespace beatvst
@@ -3,17 +3,20 @@
 #include "BeatController.h"
 
 #include "BeatEngine.h"
+#include "BeatState.h"
+#include "BeatStateStream.h"
+#include "pluginterfaces/base/smartpointer.h"
 #include "pluginterfaces/base/ustring.h"
 #include "vstgui/uidescription/delegationcontroller.h"
 #include "vstgui/plugin-bindings/vst3editor.h"
 #include "vstgui/uidescription/uidescription.h"
 #include "vstgui/lib/controls/cautoanimation.h"
 #include "vstgui/lib/controls/cbuttons.h"
-#include "base/source/fstreamer.h"
 #include <algorithm>
 #include <array>
 #include <cctype>
 #include <cmath>
+#include <cstdint>
 #include <cstring>
 #include <string>
 
@@ -23,7 +26,12 @@ using namespace Steinberg::Vst;
 
 namespace {
 
-constexpr int32_t kBeatSelectButtonTagBase = 91;
+// Beat Select buttons are not parameters; their tags sit above every parameter
+// ID so the editor never binds them to one.
+constexpr int32_t kBeatSelectButtonTagBase = 1000;
+static_assert(kBeatSelectButtonTagBase >= kParamCount, "Beat Select button tags overlap parameter IDs");
+// Lane lights are polled from the processor at about 30 Hz.
+constexpr uint32_t kActivityPollMs = 33;
 constexpr int32_t kBeatSelectButtonTagLast = kBeatSelectButtonTagBase + kMaxBeats - 1;
 
 bool isBeatSelectButtonTag(int32_t tag) {
@@ -130,85 +138,39 @@ private:
     std::array<VSTGUI::CTextButton*, kMaxBeats> laneButtons_ {};
 };
 
+// "Lane N Name" for lane params, written straight into the host string.
+void paramTitle(const BeatParamDesc& desc, String128 title) {
+    int n = 0;
+    auto put = [&](char c) {
+        if (n < 127) title[n++] = static_cast<TChar>(c);
+    };
+    if (desc.lane >= 0) {
+        for (const char* c = "Lane "; *c; ++c) put(*c);
+        const int number = desc.lane + 1;
+        if (number >= 10) put(static_cast<char>('0' + number / 10));
+        put(static_cast<char>('0' + number % 10));
+        put(' ');
+    }
+    for (const char* c = desc.name; *c; ++c) put(*c);
+    title[n] = 0;
+}
+
 } // namespace
 
 tresult PLUGIN_API BeatController::initialize(FUnknown* context) {
     tresult res = EditControllerEx1::initialize(context);
     if (res != kResultOk) return res;
 
-    // Effect on/off
-    RangeParameter* effectEnabled = new RangeParameter(STR16("Mute All"), ParamIDs::kParamEffectEnabled, nullptr, 0.0, 1.0, 0.0);
-    parameters.addParameter(effectEnabled);
-
-    RangeParameter* globalSolo = new RangeParameter(STR16("Global Solo"), kParamGlobalSolo, nullptr, 0.0, 1.0, 0.0);
-    globalSolo->setPrecision(0);
-    parameters.addParameter(globalSolo);
-
-    RangeParameter* beatSelect = new RangeParameter(STR16("Beat Select"), ParamIDs::kParamBeatSelect, nullptr, 1.0, static_cast<ParamValue>(kMaxBeats), 1.0);
-    beatSelect->setPrecision(0);
-    parameters.addParameter(beatSelect);
-
-    RangeParameter* resetParam = new RangeParameter(STR16("Reset"), ParamIDs::kParamReset, nullptr, 0.0, 1.0, 0.0);
-    resetParam->setPrecision(0);
-    parameters.addParameter(resetParam);
-
-    auto addActiveParam = [&](const std::string& label, ParamID id, double min, double max, double def, int precision) {
+    parameters.init(kParamCount);
+    for (ParamID pid : kParamRegistrationOrder) {
+        const BeatParamDesc& desc = kParamTable[pid];
         String128 title{};
-        UString(title, str16BufferSize(String128)).fromAscii(label.c_str());
-        auto* p = new RangeParameter(title, id, nullptr, min, max, def);
-        p->setPrecision(precision);
-        p->getInfo().flags |= ParameterInfo::kIsHidden;
-        parameters.addParameter(p);
-    };
-
-    addActiveParam("Bars", activeParamId(ActiveParamSlot::kActiveBars), 1, kMaxLoopLength, 4, 0);
-    addActiveParam("Loop", activeParamId(ActiveParamSlot::kActiveLoop), 1, kMaxLoopLength, 16, 0);
-    addActiveParam("Beats", activeParamId(ActiveParamSlot::kActiveBeats), 0, kMaxLoopLength, 4, 0);
-    addActiveParam("Rotate", activeParamId(ActiveParamSlot::kActiveRotate), 0, kMaxLoopLength, 0, 0);
-    addActiveParam("NoteIndex", activeParamId(ActiveParamSlot::kActiveNoteIndex), 0, 11, 0, 0);
-    addActiveParam("Octave", activeParamId(ActiveParamSlot::kActiveOctave), kMinOctave, kMaxOctave, 2, 0);
-    addActiveParam("Loud", activeParamId(ActiveParamSlot::kActiveLoud), 0, 127, 0, 0);
-
-    auto addBeatParam = [&](int beat, const std::string& label, ParamID id, double min, double max, double def, int precision, UnitID unitId) {
-        String128 title{};
-        UString(title, str16BufferSize(String128)).fromAscii(label.c_str());
-        auto* p = new RangeParameter(title, id, nullptr, min, max, def);
-        p->setPrecision(precision);
-        p->setUnitID(unitId);
-        parameters.addParameter(p);
-    };
+        paramTitle(desc, title);
+        auto* param = new RangeParameter(title, pid, nullptr, desc.min, desc.max, desc.def, 0, desc.flags);
+        param->setPrecision(0);
+        parameters.addParameter(param);
+    }
 
-    for (int b = 0; b < kMaxBeats; ++b) {
-        const int laneNumber = b + 1;
-        addBeatParam(b, "Lane " + std::to_string(laneNumber) + " Bars", beatParamId(b, BeatParamSlot::kSlotBars), 1, kMaxLoopLength, 4, 0, kRootUnitId);
-        addBeatParam(b, "Lane " + std::to_string(laneNumber) + " Loop", beatParamId(b, BeatParamSlot::kSlotLoop), 1, kMaxLoopLength, 16, 0, kRootUnitId);
-        addBeatParam(b, "Lane " + std::to_string(laneNumber) + " Beats", beatParamId(b, BeatParamSlot::kSlotBeats), 0, kMaxLoopLength, 4, 0, kRootUnitId);
-        addBeatParam(b, "Lane " + std::to_string(laneNumber) + " Rotate", beatParamId(b, BeatParamSlot::kSlotRotate), 0, kMaxLoopLength, 0, 0, kRootUnitId);
-        addBeatParam(b, "Lane " + std::to_string(laneNumber) + " Note", beatParamId(b, BeatParamSlot::kSlotNoteIndex), 0, 11, b % 12, 0, kRootUnitId);
-        addBeatParam(b, "Lane " + std::to_string(laneNumber) + " Octave", beatParamId(b, BeatParamSlot::kSlotOctave), kMinOctave, kMaxOctave, 2, 0, kRootUnitId);
-        addBeatParam(b, "Lane " + std::to_string(laneNumber) + " Loud", beatParamId(b, BeatParamSlot::kSlotLoud), 0, 127, 0, 0, kRootUnitId);
-
-        String128 laneMuteTitle{};
-        UString(laneMuteTitle, str16BufferSize(String128)).fromAscii(("Lane " + std::to_string(laneNumber) + " Mute").c_str());
-        auto* laneMute = new RangeParameter(laneMuteTitle, laneMuteParamId(b), nullptr, 0.0, 1.0, 0.0);
-        laneMute->setPrecision(0);
-        parameters.addParameter(laneMute);
-
-        String128 laneSoloTitle{};
-        UString(laneSoloTitle, str16BufferSize(String128)).fromAscii(("Lane " + std::to_string(laneNumber) + " Solo").c_str());
-        auto* laneSolo = new RangeParameter(laneSoloTitle, laneSoloParamId(b), nullptr, 0.0, 1.0, 0.0);
-        laneSolo->setPrecision(0);
-        parameters.addParameter(laneSolo);
-
-        String128 laneActivityTitle{};
-        UString(laneActivityTitle, str16BufferSize(String128)).fromAscii(("Lane " + std::to_string(laneNumber) + " Activity").c_str());
-        auto* laneActivity = new RangeParameter(laneActivityTitle, laneActivityParamId(b), nullptr, 0.0, 1.0, 0.0);
-        laneActivity->setPrecision(0);
-        laneActivity->getInfo().flags = ParameterInfo::kIsReadOnly;
-        parameters.addParameter(laneActivity);
-    }
-
-    buildParamOrder();
     return kResultOk;
 }
 
@@ -238,73 +200,80 @@ VSTGUI::CView* BeatController::verifyView(VSTGUI::CView* view, const VSTGUI::UIA
 }
 
 void BeatController::didOpen(VSTGUI::VST3Editor* editor) {
-    if (autoExposed_) return;
-    exposeAutomatableParams();
-    autoExposed_ = true;
+    activityTimer_ = VSTGUI::makeOwned<VSTGUI::CVSTGUITimer>([this](VSTGUI::CVSTGUITimer*) { pollActivity(); },
+                                                              kActivityPollMs);
 }
 
-void BeatController::exposeAutomatableParams() {
-    if (!componentHandler) return;
-    const int32 count = parameters.getParameterCount();
-    for (int32 i = 0; i < count; ++i) {
-        auto* param = parameters.getParameterByIndex(i);
-        if (!param) continue;
-        const auto flags = param->getInfo().flags;
-        if (flags & ParameterInfo::kIsHidden) continue;
-        if (flags & ParameterInfo::kIsReadOnly) continue;
-        const ParamID pid = param->getInfo().id;
-        const ParamValue value = getParamNormalized(pid);
-        ParamValue nudge = value + 1e-5;
-        if (nudge > 1.0) nudge = value - 1e-5;
-        if (nudge < 0.0) nudge = value;
-        beginEdit(pid);
-        performEdit(pid, nudge);
-        performEdit(pid, value);
-        endEdit(pid);
+void BeatController::willClose(VSTGUI::VST3Editor* editor) {
+    if (activityTimer_) {
+        activityTimer_->stop();
+        activityTimer_ = nullptr;
     }
 }
 
-tresult PLUGIN_API BeatController::getState(IBStream* state) {
-    IBStreamer streamer(state, kLittleEndian);
-    for (auto pid : paramOrder_) {
-        ParamValue v = getParamNormalized(pid);
-        if (!streamer.writeDouble(v)) return kResultFalse;
+tresult PLUGIN_API BeatController::connect(IConnectionPoint* other) {
+    tresult res = EditControllerEx1::connect(other);
+    if (res == kResultOk && pendingProcessorSync_) pushAllParamsToProcessor();
+    return res;
+}
+
+tresult PLUGIN_API BeatController::notify(IMessage* message) {
+    if (!message) return kInvalidArgument;
+    if (!FIDStringsEqual(message->getMessageID(), kBeatActivityMessage)) {
+        return EditControllerEx1::notify(message);
+    }
+    int64 lit = 0;
+    IAttributeList* attributes = message->getAttributes();
+    if (!attributes || attributes->getInt(kBeatActivityLitAttr, lit) != kResultOk) return kResultFalse;
+    const auto lanes = static_cast<BeatLaneMask>(lit);
+    for (int b = 0; b < kMaxBeats; ++b) {
+        const ParamID pid = laneActivityParamId(b);
+        const ParamValue v = ((lanes >> b) & 1u) != 0 ? 1.0 : 0.0;
+        if (getParamNormalized(pid) != v) EditControllerEx1::setParamNormalized(pid, v);
     }
     return kResultOk;
 }
 
+void BeatController::pollActivity() {
+    if (!peerConnection) return;
+    IPtr<IMessage> message = owned(allocateMessage());
+    if (!message) return;
+    message->setMessageID(kBeatActivityPollMessage);
+    sendMessage(message);
+}
+
+tresult PLUGIN_API BeatController::getState(IBStream* state) {
+    std::array<double, kStateValueCount> values{};
+    for (size_t i = 0; i < values.size(); ++i) values[i] = getParamNormalized(kStateParamIds[i]);
+    std::vector<uint8_t> bytes = encodeState(values.data());
+    return writeStateStream(state, bytes) ? kResultOk : kResultFalse;
+}
+
 tresult PLUGIN_API BeatController::setComponentState(IBStream* state) {
     if (!state) return kInvalidArgument;
-    IBStreamer streamer(state, kLittleEndian);
-    for (auto pid : paramOrder_) {
-        double v = 0.0;
-        if (!streamer.readDouble(v)) v = defaultNormalized(pid);
-        if (pid != kParamGlobalSolo) {
-            setParamNormalized(pid, v);
-        }
-    }
-    syncGlobalSolo();
-    syncActiveParams();
-    if (componentHandler) {
-        pushAllParamsToProcessor();
-    } else {
-        pendingProcessorSync_ = true;
-    }
-    return kResultOk;
+    return loadState(state);
 }
 
 tresult PLUGIN_API BeatController::setState(IBStream* state) {
-    IBStreamer streamer(state, kLittleEndian);
-    for (auto pid : paramOrder_) {
-        double v = 0.0;
-        if (!streamer.readDouble(v)) v = defaultNormalized(pid);
-        if (pid != kParamGlobalSolo) {
-            setParamNormalized(pid, v);
-        }
-    }
-    syncGlobalSolo();
+    return loadState(state);
+}
+
+tresult BeatController::loadState(IBStream* state) {
+    std::vector<uint8_t> bytes;
+    if (!readStateStream(state, bytes)) return kResultFalse;
+    std::array<double, kStateValueCount> values = kStateDefaults;
+    if (!decodeState(bytes.data(), bytes.size(), values.data())) return kResultFalse;
+    // Through the base setter: the override's follow-up edits (Mute All onto the
+    // lane mutes, solo, the active section) would reach the host as edits, dirty
+    // the project and land in the processor after the loaded state.
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (kStateParamIds[i] != kParamGlobalSolo) EditControllerEx1::setParamNormalized(kStateParamIds[i], values[i]);
+    }
+    syncGlobalSolo(false);
     syncActiveParams();
-    if (componentHandler) {
+    // Every value may have changed; let the host re-read them once.
+    if (componentHandler) componentHandler->restartComponent(kParamValuesChanged);
+    if (peerConnection) {
         pushAllParamsToProcessor();
     } else {
         pendingProcessorSync_ = true;
@@ -313,7 +282,7 @@ tresult PLUGIN_API BeatController::setState(IBStream* state) {
 }
 
 tresult PLUGIN_API BeatController::setParamNormalized(ParamID pid, ParamValue value) {
-    if (pendingProcessorSync_ && componentHandler) {
+    if (pendingProcessorSync_ && peerConnection) {
         pushAllParamsToProcessor();
     }
     tresult res = EditControllerEx1::setParamNormalized(pid, value);
@@ -382,30 +351,21 @@ tresult PLUGIN_API BeatController::setParamNormalized(ParamID pid, ParamValue va
     return res;
 }
 
-tresult PLUGIN_API BeatController::setComponentHandler(IComponentHandler* handler) {
-    tresult res = EditControllerEx1::setComponentHandler(handler);
-    if (res == kResultOk && handler && !autoExposed_) {
-        exposeAutomatableParams();
-        autoExposed_ = true;
-    }
-    return res;
-}
-
+// Sends the whole state as one message instead of an edit per parameter, so a
+// project load adds nothing to the host's undo history or automation.
 void BeatController::pushAllParamsToProcessor() {
-    if (!componentHandler || pushingToProcessor_) return;
-    pushingToProcessor_ = true;
+    if (!peerConnection) return;
     pendingProcessorSync_ = false;
-    for (auto pid : paramOrder_) {
-        if (pid == ParamIDs::kParamReset) continue;
-        if (pid >= kActiveParamBase && pid < kLaneMuteBase) continue;
-        if (pid >= kLaneActivityBase) continue;
-        if (pid == kParamGlobalSolo) continue;
-        const ParamValue v = getParamNormalized(pid);
-        componentHandler->beginEdit(pid);
-        componentHandler->performEdit(pid, v);
-        componentHandler->endEdit(pid);
-    }
-    pushingToProcessor_ = false;
+    IPtr<IMessage> message = owned(allocateMessage());
+    if (!message) return;
+    std::array<double, kStateValueCount> values{};
+    for (size_t i = 0; i < values.size(); ++i) values[i] = getParamNormalized(kStateParamIds[i]);
+    const std::vector<uint8_t> bytes = encodeState(values.data());
+    message->setMessageID(kBeatStateMessage);
+    IAttributeList* attributes = message->getAttributes();
+    if (!attributes) return;
+    attributes->setBinary(kBeatStateValuesAttr, bytes.data(), static_cast<uint32>(bytes.size()));
+    sendMessage(message);
 }
 
 void BeatController::applyGlobalMuteToLanes(bool muted) {
@@ -435,7 +395,7 @@ void BeatController::applyGlobalSoloClear() {
     componentHandler->endEdit(kParamGlobalSolo);
 }
 
-void BeatController::syncGlobalSolo() {
+void BeatController::syncGlobalSolo(bool notifyHost) {
     bool anySolo = false;
     for (int b = 0; b < kMaxBeats; ++b) {
         const ParamID pid = laneSoloParamId(b);
@@ -443,7 +403,7 @@ void BeatController::syncGlobalSolo() {
     }
     const ParamValue v = anySolo ? 1.0 : 0.0;
     EditControllerEx1::setParamNormalized(kParamGlobalSolo, v);
-    if (componentHandler) {
+    if (notifyHost && componentHandler) {
         componentHandler->beginEdit(kParamGlobalSolo);
         componentHandler->performEdit(kParamGlobalSolo, v);
         componentHandler->endEdit(kParamGlobalSolo);
@@ -505,70 +465,10 @@ tresult PLUGIN_API BeatController::getParamValueByString(ParamID pid, TChar* str
     return EditControllerEx1::getParamValueByString(pid, string, valueNormalized);
 }
 
-void BeatController::buildParamOrder() {
-    paramOrder_.clear();
-    paramOrder_.push_back(ParamIDs::kParamEffectEnabled);
-    paramOrder_.push_back(ParamIDs::kParamBeatSelect);
-    for (int b = 0; b < kMaxBeats; ++b) {
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotBars));
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotLoop));
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotBeats));
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotRotate));
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotNoteIndex));
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotOctave));
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotLoud));
-        paramOrder_.push_back(laneMuteParamId(b));
-        paramOrder_.push_back(laneSoloParamId(b));
-    }
-    paramOrder_.push_back(kParamGlobalSolo);
-}
-
-ParamValue BeatController::defaultNormalized(ParamID pid) const {
-    if (pid == ParamIDs::kParamEffectEnabled) return 0.0;
-    if (pid == kParamGlobalSolo) return 0.0;
-    if (pid == ParamIDs::kParamBeatSelect) return 0.0;
-
-    if (pid < kParamBaseBeatParams) return 0.0;
-
-    if (pid >= kActiveParamBase && pid < kLaneMuteBase) {
-        int slot = static_cast<int>(pid - kActiveParamBase);
-        switch (slot) {
-            case ActiveParamSlot::kActiveBars: return (4.0 - 1.0) / (kMaxLoopLength - 1.0);
-            case ActiveParamSlot::kActiveLoop: return (16.0 - 1.0) / (kMaxLoopLength - 1.0);
-            case ActiveParamSlot::kActiveBeats: return 4.0 / kMaxLoopLength;
-            case ActiveParamSlot::kActiveRotate: return 0.0;
-            case ActiveParamSlot::kActiveNoteIndex: return 0.0;
-            case ActiveParamSlot::kActiveOctave: return (2.0 - kMinOctave) / (kMaxOctave - kMinOctave);
-            case ActiveParamSlot::kActiveLoud: return 0.0;
-            default: break;
-        }
-        return 0.0;
-    }
-
-    if (pid >= kLaneMuteBase && pid < kLaneSoloBase) return 0.0;
-    if (pid >= kLaneSoloBase && pid < kLaneActivityBase) return 0.0;
-    if (pid >= kLaneActivityBase) return 0.0;
-
-    int rel = static_cast<int>(pid - kParamBaseBeatParams);
-    int beatIndex = rel / kPerBeatParams;
-    int slot = rel % kPerBeatParams;
-
-    switch (slot) {
-        case BeatParamSlot::kSlotBars: return (4.0 - 1.0) / (kMaxLoopLength - 1.0);
-        case BeatParamSlot::kSlotLoop: return (16.0 - 1.0) / (kMaxLoopLength - 1.0);
-        case BeatParamSlot::kSlotBeats: return 4.0 / kMaxLoopLength;
-        case BeatParamSlot::kSlotRotate: return 0.0;
-        case BeatParamSlot::kSlotNoteIndex: return static_cast<ParamValue>(beatIndex % 12) / 11.0;
-        case BeatParamSlot::kSlotOctave: return (2.0 - kMinOctave) / (kMaxOctave - kMinOctave);
-        case BeatParamSlot::kSlotLoud: return 0.0;
-        default: break;
-    }
-    return 0.0;
-}
-
 void BeatController::resetAllParams() {
-    for (auto pid : paramOrder_) {
-        ParamValue v = defaultNormalized(pid);
+    for (size_t i = 0; i < kStateParamIds.size(); ++i) {
+        const ParamID pid = kStateParamIds[i];
+        const ParamValue v = kStateDefaults[i];
         beginEdit(pid);
         performEdit(pid, v);
         endEdit(pid);
@@ -577,20 +477,19 @@ void BeatController::resetAllParams() {
     syncActiveParams();
 }
 
+// Mirrors the selected lane into the editor's active section. The active params
+// are hidden and the processor ignores them, so the host needs no restart; each
+// slot that changes notifies its own controls.
 void BeatController::syncActiveParams() {
     if (syncingActive_) return;
     syncingActive_ = true;
     const int beatIndex = selectedBeatIndex();
     for (int slot = 0; slot < kPerBeatParams; ++slot) {
-        ParamID src = beatParamId(beatIndex, slot);
-        ParamID dst = activeParamId(slot);
-        ParamValue v = getParamNormalized(src);
-        EditControllerEx1::setParamNormalized(dst, v);
+        const ParamID dst = activeParamId(slot);
+        const ParamValue v = getParamNormalized(beatParamId(beatIndex, slot));
+        if (getParamNormalized(dst) != v) EditControllerEx1::setParamNormalized(dst, v);
     }
     syncingActive_ = false;
-    if (componentHandler) {
-        componentHandler->restartComponent(Vst::kParamValuesChanged);
-    }
 }
 
 int BeatController::selectedBeatIndex() {
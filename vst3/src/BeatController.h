@@ -3,8 +3,10 @@
 #pragma once
 
 #include "BeatIDs.h"
+#include "BeatParamTable.h"
 
 #include "public.sdk/source/vst/vsteditcontroller.h"
+#include "vstgui/lib/cvstguitimer.h"
 #include "vstgui/plugin-bindings/vst3editor.h"
 
 namespace beatvst {
@@ -25,30 +27,29 @@ public:
                                                         Steinberg::Vst::String128 string) SMTG_OVERRIDE;
     Steinberg::tresult PLUGIN_API getParamValueByString(Steinberg::Vst::ParamID pid, Steinberg::Vst::TChar* string,
                                                         Steinberg::Vst::ParamValue& valueNormalized) SMTG_OVERRIDE;
-    Steinberg::tresult PLUGIN_API setComponentHandler(Steinberg::Vst::IComponentHandler* handler) SMTG_OVERRIDE;
+    Steinberg::tresult PLUGIN_API connect(Steinberg::Vst::IConnectionPoint* other) SMTG_OVERRIDE;
+    Steinberg::tresult PLUGIN_API notify(Steinberg::Vst::IMessage* message) SMTG_OVERRIDE;
     VSTGUI::IController* createSubController(VSTGUI::UTF8StringPtr name, const VSTGUI::IUIDescription* description,
                                              VSTGUI::VST3Editor* editor) SMTG_OVERRIDE;
     VSTGUI::CView* verifyView(VSTGUI::CView* view, const VSTGUI::UIAttributes& attributes,
                               const VSTGUI::IUIDescription* description, VSTGUI::VST3Editor* editor) SMTG_OVERRIDE;
     void didOpen(VSTGUI::VST3Editor* editor) SMTG_OVERRIDE;
+    void willClose(VSTGUI::VST3Editor* editor) SMTG_OVERRIDE;
 
 private:
-    void buildParamOrder();
-    Steinberg::Vst::ParamValue defaultNormalized(Steinberg::Vst::ParamID pid) const;
+    Steinberg::tresult loadState(Steinberg::IBStream* state);
     void resetAllParams();
     void pushAllParamsToProcessor();
     void applyGlobalMuteToLanes(bool muted);
     void applyGlobalSoloClear();
-    void syncGlobalSolo();
+    void syncGlobalSolo(bool notifyHost = true);
     void syncActiveParams();
-    void exposeAutomatableParams();
     int selectedBeatIndex();
     bool isNoteParam(Steinberg::Vst::ParamID pid) const;
+    void pollActivity();
     bool syncingActive_{false};
     bool pendingProcessorSync_{false};
-    bool pushingToProcessor_{false};
-    bool autoExposed_{false};
-    std::vector<Steinberg::Vst::ParamID> paramOrder_;
+    VSTGUI::SharedPointer<VSTGUI::CVSTGUITimer> activityTimer_;
 };
 
 } // namespace beatvst
@@ -4,9 +4,7 @@
 
 #include <algorithm>
 #include <cmath>
-#include <functional>
-#include <stdexcept>
-#include <string>
+#include <cstring>
 
 namespace beatvst {
 
@@ -16,48 +14,75 @@ namespace {
 constexpr const char* kNotes[] = {"C","C#","D","D#","E","F","F#","G","G#","A","A#","B"};
 constexpr int kNotesCount = 12;
 
-std::vector<int> bjorklund(int steps, int pulses) {
-    if (pulses > steps) throw std::invalid_argument("pulses > steps");
-    std::vector<int> pattern;
-    if (pulses == 0) {
-        pattern.assign(static_cast<size_t>(steps), 0);
-        return pattern;
+// Bjorklund's algorithm evaluated at compile time. Step i of the pattern is bit i
+// of the result, rotated so the first step is a hit (matches the Python version).
+struct PatternBuilder {
+    uint32_t mask{0};
+    int length{0};
+};
+
+constexpr void bjorklundBuild(int level, const int* counts, const int* remainders, PatternBuilder& out) {
+    if (level == -1) {
+        out.length++;
+    } else if (level == -2) {
+        out.mask |= 1u << out.length;
+        out.length++;
+    } else {
+        for (int i = 0; i < counts[level]; ++i) bjorklundBuild(level - 1, counts, remainders, out);
+        if (remainders[level] != 0) bjorklundBuild(level - 2, counts, remainders, out);
     }
+}
+
+constexpr uint32_t bjorklund(int steps, int pulses) {
+    if (steps <= 0 || pulses <= 0 || pulses > steps) return 0;
 
-    std::vector<int> counts;
-    std::vector<int> remainders;
-    remainders.push_back(pulses);
+    int counts[kMaxLoopLength + 1]{};
+    int remainders[kMaxLoopLength + 2]{};
+    remainders[0] = pulses;
     int divisor = steps - pulses;
     int level = 0;
     while (true) {
-        counts.push_back(divisor / remainders[static_cast<size_t>(level)]);
-        remainders.push_back(divisor % remainders[static_cast<size_t>(level)]);
-        divisor = remainders[static_cast<size_t>(level)];
+        counts[level] = divisor / remainders[level];
+        remainders[level + 1] = divisor % remainders[level];
+        divisor = remainders[level];
         level++;
-        if (remainders[static_cast<size_t>(level)] < 2) break;
+        if (remainders[level] < 2) break;
     }
-    counts.push_back(divisor);
+    counts[level] = divisor;
 
-    std::function<void(int)> build = [&](int l) {
-        if (l == -1) {
-            pattern.push_back(0);
-        } else if (l == -2) {
-            pattern.push_back(1);
-        } else {
-            for (int i = 0; i < counts[static_cast<size_t>(l)]; ++i) build(l - 1);
-            if (remainders[static_cast<size_t>(l)] != 0) build(l - 2);
+    PatternBuilder pattern{};
+    bjorklundBuild(level, counts, remainders, pattern);
+    int first = 0;
+    while (first < steps && !((pattern.mask >> first) & 1u)) ++first;
+    return rotatePattern(pattern.mask, steps, steps - first);
+}
+
+constexpr int kPatternTableStride = kMaxLoopLength + 1;
+
+constexpr std::array<uint32_t, kPatternTableStride * kPatternTableStride> makePatternTable() {
+    std::array<uint32_t, kPatternTableStride * kPatternTableStride> table{};
+    for (int steps = 1; steps <= kMaxLoopLength; ++steps) {
+        for (int pulses = 0; pulses <= steps; ++pulses) {
+            table[static_cast<size_t>(steps * kPatternTableStride + pulses)] = bjorklund(steps, pulses);
         }
-    };
-    build(level);
-    auto it = std::find(pattern.begin(), pattern.end(), 1);
-    if (it != pattern.end()) {
-        std::rotate(pattern.begin(), it, pattern.end());
     }
-    return pattern;
+    return table;
 }
 
+constexpr auto kPatternTable = makePatternTable();
+
+static_assert(kPatternTable[8 * kPatternTableStride + 3] == 0b01001001u, "E(3,8) = x..x..x.");
+static_assert(kPatternTable[16 * kPatternTableStride + 4] == 0x1111u, "E(4,16) = four on the floor");
+static_assert(kPatternTable[5 * kPatternTableStride + 2] == 0b00101u, "E(2,5) = x.x..");
+static_assert(kPatternTable[32 * kPatternTableStride + 32] == 0xFFFFFFFFu, "E(32,32) = all hits");
+
 } // namespace
 
+uint32_t euclideanPattern(int loop, int beats) {
+    if (loop <= 0 || loop > kMaxLoopLength || beats <= 0 || beats > loop) return 0;
+    return kPatternTable[static_cast<size_t>(loop * kPatternTableStride + beats)];
+}
+
 uint8_t noteIndexToMidi(int octave, int noteIndex) {
     if (noteIndex < 0 || noteIndex >= kNotesCount) return 60;
     int number = noteIndex + ((octave + 1) * 12);
@@ -65,10 +90,68 @@ uint8_t noteIndexToMidi(int octave, int noteIndex) {
     return static_cast<uint8_t>(number);
 }
 
+void NoteOffQueue::schedule(int lane, int tick) {
+    cancel(lane);
+    const int index = size_++;
+    place(index, Entry{tick, lane});
+    siftUp(index);
+}
+
+void NoteOffQueue::cancel(int lane) {
+    const int index = position_[static_cast<size_t>(lane)];
+    if (index >= 0) removeAt(index);
+}
+
+void NoteOffQueue::pop() {
+    removeAt(0);
+}
+
+void NoteOffQueue::clear() {
+    for (int i = 0; i < size_; ++i) position_[static_cast<size_t>(heap_[static_cast<size_t>(i)].lane)] = -1;
+    size_ = 0;
+}
+
+void NoteOffQueue::place(int index, const Entry& entry) {
+    heap_[static_cast<size_t>(index)] = entry;
+    position_[static_cast<size_t>(entry.lane)] = index;
+}
+
+void NoteOffQueue::siftUp(int index) {
+    const Entry entry = heap_[static_cast<size_t>(index)];
+    while (index > 0) {
+        const int parent = (index - 1) / 2;
+        if (heap_[static_cast<size_t>(parent)].tick <= entry.tick) break;
+        place(index, heap_[static_cast<size_t>(parent)]);
+        index = parent;
+    }
+    place(index, entry);
+}
+
+void NoteOffQueue::siftDown(int index) {
+    const Entry entry = heap_[static_cast<size_t>(index)];
+    while (true) {
+        int child = index * 2 + 1;
+        if (child >= size_) break;
+        if (child + 1 < size_ && heap_[static_cast<size_t>(child + 1)].tick < heap_[static_cast<size_t>(child)].tick) ++child;
+        if (entry.tick <= heap_[static_cast<size_t>(child)].tick) break;
+        place(index, heap_[static_cast<size_t>(child)]);
+        index = child;
+    }
+    place(index, entry);
+}
+
+void NoteOffQueue::removeAt(int index) {
+    position_[static_cast<size_t>(heap_[static_cast<size_t>(index)].lane)] = -1;
+    const int last = --size_;
+    if (index == last) return;
+    place(index, heap_[static_cast<size_t>(last)]);
+    siftDown(index);
+    siftUp(index);
+}
+
 Beat::Beat(int index) : index_(index) {
     params_.noteIndex = index_ % kNotesCount;
     rebuildNotes();
-    rebuildPattern();
 }
 
 void Beat::rebuildNotes() {
@@ -77,136 +160,133 @@ void Beat::rebuildNotes() {
     updateNotes_ = false;
 }
 
-void Beat::rebuildPattern() {
-    if (params_.loop < params_.beats) {
-        mute_ = true;
-        updatePattern_ = false;
-        return;
-    }
-
-    try {
-        truths_ = bjorklund(params_.loop, params_.beats);
-    } catch (...) {
-        truths_.assign(static_cast<size_t>(params_.loop), 0);
-    }
-
-    if (params_.rotate != 0 && !truths_.empty()) {
-        int r = params_.rotate % static_cast<int>(truths_.size());
-        if (r < 0) r += static_cast<int>(truths_.size());
-        std::rotate(truths_.begin(), truths_.end() - r, truths_.end());
-    }
-
-    int ticksPerBar = params_.bars * 4 * 24;
-    tickCountdown_ = 0;
-    truthIndex_ = 0;
-    // run() is called every tick; advance steps based on ticks per bar and loop length.
-    int ticksPerStep = static_cast<int>(std::round(ticksPerBar / static_cast<double>(params_.loop)));
-    stepTicks_ = std::max(1, ticksPerStep);
-    tickCountdown_ = 0;
-    updatePattern_ = false;
-    checkMute();
+void Beat::updateSustain() {
+    sustainTicks_ = std::max(1, params_.gate * kTicksPerQuarter / kGateTicksPerQuarter);
 }
 
 void Beat::checkMute() {
-    mute_ = (params_.beats == 0) || (params_.loud == 0);
+    // A loop shorter than its beats has no pattern to play (see silent()).
+    mute_ = (params_.beats == 0) || (params_.loud == 0) || (params_.loop < params_.beats);
     if (mute_) muted_ = false;
 }
 
-bool Beat::setParam(const char* name, int value) {
-    const std::string key(name);
-    if (key == "Bars") params_.bars = value;
-    else if (key == "Loop") params_.loop = value;
-    else if (key == "Beats") params_.beats = value;
-    else if (key == "Rotate") params_.rotate = value;
-    else if (key == "Octave") params_.octave = value;
-    else if (key == "Note" || key == "NoteIndex") params_.noteIndex = value;
-    else if (key == "Loud") params_.loud = value;
-    else return false;
-
-    if (key == "Octave" || key == "Note" || key == "NoteIndex") {
-        updateNotes_ = true;
-    } else if (key == "Loud") {
-        // Loudness should not rebuild the pattern; it only affects velocity/mute.
-        updatePattern_ = false;
-    } else {
-        updatePattern_ = true;
+bool Beat::setParam(BeatParamSlot slot, int value) {
+    // Rewriting a value a lane already has (hosts resend whole states) changes nothing.
+    auto change = [value](int& field, bool& update) {
+        if (field == value) return;
+        field = value;
+        update = true;
+    };
+    switch (slot) {
+        case kSlotBars: change(params_.bars, updatePattern_); break;
+        case kSlotLoop: change(params_.loop, updatePattern_); break;
+        case kSlotBeats: change(params_.beats, updatePattern_); break;
+        case kSlotRotate: change(params_.rotate, updatePattern_); break;
+        case kSlotNoteIndex: change(params_.noteIndex, updateNotes_); break;
+        case kSlotOctave: change(params_.octave, updateNotes_); break;
+        case kSlotLoud:
+            // Loudness only affects velocity/mute; a rebuild already pending stays pending.
+            params_.loud = value;
+            break;
+        case kSlotGate: params_.gate = value; updateSustain(); break;
+        default: return false;
     }
     checkMute();
     return true;
 }
 
+bool Beat::setParam(const char* name, int value) {
+    static constexpr struct {
+        const char* name;
+        BeatParamSlot slot;
+    } kNames[] = {
+        {"Bars", kSlotBars}, {"Loop", kSlotLoop}, {"Beats", kSlotBeats}, {"Rotate", kSlotRotate},
+        {"Octave", kSlotOctave}, {"Note", kSlotNoteIndex}, {"NoteIndex", kSlotNoteIndex}, {"Loud", kSlotLoud},
+        {"Gate", kSlotGate},
+    };
+    for (const auto& entry : kNames) {
+        if (std::strcmp(name, entry.name) == 0) return setParam(entry.slot, value);
+    }
+    return false;
+}
+
 void Beat::setParams(const BeatParams& p) {
     params_ = p;
     updateNotes_ = true;
     updatePattern_ = true;
+    updateSustain();
     checkMute();
 }
 
-void Beat::tick(int globalTick, std::vector<BeatEvent>& out) {
-    if (updateNotes_) {
-        if (offTick_ != 0) {
-            BeatEvent ev{index_, noteOff_, 0, false};
-            out.push_back(ev);
-            offTick_ = 0;
-        }
-        rebuildNotes();
-    }
-    if (updatePattern_) {
-        if (offTick_ != 0) {
-            BeatEvent ev{index_, noteOff_, 0, false};
-            out.push_back(ev);
-            offTick_ = 0;
-        }
-        rebuildPattern();
-        // Avoid bursts by restarting on the next step after a structural change.
-        tickCountdown_ = stepTicks_;
-        return;
+BeatEngine::BeatEngine() {
+    for (int i = 0; i < kMaxBeats; ++i) {
+        beats_[static_cast<size_t>(i)] = Beat(i);
+        rebuildLanePattern(i);
+        classifyLane(i);
     }
+}
 
-    const bool effectiveMute = mute_ || externalMute_;
-    if (effectiveMute) {
-        if (!muted_) {
-            muted_ = true;
-            BeatEvent ev{index_, noteOff_, 0, false};
-            out.push_back(ev);
-        }
-        return;
-    }
-    muted_ = false;
+int Beat::stepTicks() const {
+    // Steps advance on a countdown derived from ticks per bar and loop length.
+    const int ticksPerBar = params_.bars * 4 * kTicksPerQuarter;
+    return std::max(1, static_cast<int>(std::round(ticksPerBar / static_cast<double>(params_.loop))));
+}
 
-    if (offTick_ != 0 && globalTick >= offTick_) {
-        BeatEvent ev{index_, noteOff_, 0, false};
-        out.push_back(ev);
-        offTick_ = 0;
-    }
+uint32_t Beat::pattern() const {
+    const int length = std::clamp(params_.loop, 0, kMaxLoopLength);
+    return rotatePattern(euclideanPattern(length, params_.beats), length, params_.rotate);
+}
 
-    tickCountdown_ -= 1;
-    if (tickCountdown_ > 0) return;
+bool Beat::silent() const {
+    return params_.beats == 0 || params_.loud == 0 || params_.loop < params_.beats || externalMute_;
+}
 
-    // Reset the countdown for the next step.
-    tickCountdown_ = stepTicks_;
+namespace {
 
-    if (!truths_.empty() && truths_[static_cast<size_t>(truthIndex_)] == 1) {
-        BeatEvent on{index_, noteOn_, static_cast<uint8_t>(params_.loud), true};
-        out.push_back(on);
-        offTick_ = globalTick + sustainTicks_;
-    }
+// First hit at or after step; pattern must be non-zero.
+int64_t nextHitStep(int64_t step, uint32_t pattern, int length) {
+    const int r = static_cast<int>(step % length);
+    const uint32_t ahead = pattern >> r;
+    if (ahead != 0) return step + lowestLane(ahead);
+    return step + (length - r) + lowestLane(pattern);
+}
+
+} // namespace
 
-    truthIndex_++;
-    if (truthIndex_ >= static_cast<int>(truths_.size())) truthIndex_ = 0;
+// Step k fires at tick (k + 1) * stepTicks (see BeatEngine::seekLane). A note
+// lasts its gate unless the lane's next hit ends it first, on that hit's tick.
+template <typename Visit>
+void Beat::forEachNote(int firstTick, int endTick, Visit visit) const {
+    const uint32_t hits = pattern();
+    if (silent() || hits == 0) return;
+    const int length = std::clamp(params_.loop, 1, kMaxLoopLength);
+    const int64_t step = stepTicks();
+    // The earliest hit whose note can reach firstTick.
+    const int64_t from = static_cast<int64_t>(firstTick) - sustainTicks_;
+    int64_t k = nextHitStep(from > step ? (from + step - 1) / step - 1 : 0, hits, length);
+    for (int64_t hit = (k + 1) * step; hit < endTick;) {
+        const int64_t next = nextHitStep(k + 1, hits, length);
+        const int64_t nextHit = (next + 1) * step;
+        const int64_t off = std::min<int64_t>(hit + sustainTicks_, nextHit);
+        if (off >= firstTick) visit(hit, off);
+        k = next;
+        hit = nextHit;
+    }
 }
 
-void Beat::resetTiming() {
-    truthIndex_ = 0;
-    tickCountdown_ = 0;
-    offTick_ = 0;
-    updatePattern_ = true;
-    updateNotes_ = true;
-    muted_ = false;
+void Beat::eventsInRange(int firstTick, int endTick, std::vector<BeatEvent>& out) const {
+    const uint8_t note = pitch();
+    const uint8_t velocity = static_cast<uint8_t>(params_.loud);
+    forEachNote(firstTick, endTick, [&](int64_t hit, int64_t off) {
+        if (hit >= firstTick) out.push_back(BeatEvent{index_, note, velocity, true, static_cast<int>(hit)});
+        if (off < endTick) out.push_back(BeatEvent{index_, note, 0, false, static_cast<int>(off)});
+    });
 }
 
-BeatEngine::BeatEngine() {
-    for (int i = 0; i < kMaxBeats; ++i) beats_[static_cast<size_t>(i)] = Beat(i);
+int Beat::heldHitBefore(int tick) const {
+    int held = -1;
+    forEachNote(tick, tick, [&](int64_t hit, int64_t) { held = static_cast<int>(hit); });
+    return held;
 }
 
 void BeatEngine::selectBeat(int oneBased) {
@@ -216,47 +296,374 @@ void BeatEngine::selectBeat(int oneBased) {
 
 void BeatEngine::setBeatParam(const char* name, int value) {
     beats_[static_cast<size_t>(selected_)].setParam(name, value);
+    classifyLane(selected_);
+}
+
+void BeatEngine::setLaneParam(int beatIndex, BeatParamSlot slot, int value) {
+    if (beatIndex < 0 || beatIndex >= kMaxBeats) return;
+    beats_[static_cast<size_t>(beatIndex)].setParam(slot, value);
+    classifyLane(beatIndex);
+}
+
+int BeatEngine::laneParam(int beatIndex, BeatParamSlot slot) const {
+    if (beatIndex < 0 || beatIndex >= kMaxBeats) return 0;
+    const BeatParams& p = beats_[static_cast<size_t>(beatIndex)].params_;
+    switch (slot) {
+        case kSlotBars: return p.bars;
+        case kSlotLoop: return p.loop;
+        case kSlotBeats: return p.beats;
+        case kSlotRotate: return p.rotate;
+        case kSlotNoteIndex: return p.noteIndex;
+        case kSlotOctave: return p.octave;
+        case kSlotLoud: return p.loud;
+        case kSlotGate: return p.gate;
+        default: return 0;
+    }
 }
 
 void BeatEngine::setLaneMute(int beatIndex, bool muted) {
     if (beatIndex < 0 || beatIndex >= kMaxBeats) return;
-    laneMute_[static_cast<size_t>(beatIndex)] = muted;
+    const LaneMask bit = LaneMask{1} << beatIndex;
+    laneMuteMask_ = muted ? (laneMuteMask_ | bit) : (laneMuteMask_ & ~bit);
+    applyLaneGates();
 }
 
 void BeatEngine::setLaneSolo(int beatIndex, bool solo) {
     if (beatIndex < 0 || beatIndex >= kMaxBeats) return;
-    laneSolo_[static_cast<size_t>(beatIndex)] = solo;
-    anySolo_ = false;
-    for (bool s : laneSolo_) {
-        if (s) { anySolo_ = true; break; }
+    const LaneMask bit = LaneMask{1} << beatIndex;
+    laneSoloMask_ = solo ? (laneSoloMask_ | bit) : (laneSoloMask_ & ~bit);
+    applyLaneGates();
+}
+
+void BeatEngine::applyLaneGates() {
+    // A lane is gated by its own mute, or by any solo that does not include it.
+    const LaneMask soloGate = laneSoloMask_ != 0 ? ~laneSoloMask_ : 0;
+    const LaneMask gate = (laneMuteMask_ | soloGate) & kAllLanes;
+    // Only lanes whose gate flipped need their mute edge serviced.
+    for (LaneMask changed = gate ^ gateMask_; changed != 0; changed &= changed - 1) {
+        const int i = lowestLane(changed);
+        beats_[static_cast<size_t>(i)].setExternalMute(((gate >> i) & 1u) != 0);
+        classifyLane(i);
+    }
+    gateMask_ = gate;
+}
+
+void BeatEngine::classifyLane(int i) {
+    const Beat& b = beats_[static_cast<size_t>(i)];
+    const LaneMask bit = LaneMask{1} << i;
+    runMask_ &= ~bit;
+    serviceMask_ &= ~bit;
+    // Pending rebuilds and mute edges need the scalar path; a lane that is muted
+    // and has already sent its note-off is idle until something changes.
+    if (b.updateNotes_ || b.updatePattern_ || b.effectiveMute() != b.muted_) {
+        serviceMask_ |= bit;
+    } else if (!b.effectiveMute()) {
+        runMask_ |= bit;
+    }
+}
+
+void BeatEngine::rebuildLanePattern(int i) {
+    Beat& b = beats_[static_cast<size_t>(i)];
+    const size_t lane = static_cast<size_t>(i);
+    const BeatParams& p = b.params_;
+    if (p.loop < p.beats) {
+        b.mute_ = true;
+        b.updatePattern_ = false;
+        return;
+    }
+
+    clocks_.length[lane] = std::clamp(p.loop, 0, kMaxLoopLength);
+    clocks_.pattern[lane] = b.pattern();
+    clocks_.stepTicks[lane] = b.stepTicks();
+    clocks_.countdown[lane] = 0;
+    clocks_.step[lane] = 0;
+    b.updatePattern_ = false;
+    b.checkMute();
+}
+
+bool BeatEngine::laneHit(int i, int step) const {
+    const size_t lane = static_cast<size_t>(i);
+    return clocks_.length[lane] > 0 && ((clocks_.pattern[lane] >> step) & 1u) != 0;
+}
+
+void BeatEngine::noteOn(int i, uint8_t note, uint8_t velocity, int tick, BeatEventSink& out) {
+    SoundingNote& s = sounding_[note & 0x7F];
+    if (s.holds > 0) {
+        if (s.struckAt == tick) {
+            // Another lane struck this pitch on this tick; one note-on covers both.
+            ++s.holds;
+            out.push(BeatEvent{i, note, velocity, true, 0, true});
+            return;
+        }
+        // Re-strike: end the sounding voice so the synth sees one on per off.
+        out.push(BeatEvent{i, note, 0, false});
+    }
+    ++s.holds;
+    s.lane = static_cast<int8_t>(i);
+    s.struckAt = tick;
+    out.push(BeatEvent{i, note, velocity, true});
+}
+
+void BeatEngine::noteOff(int i, uint8_t note, BeatEventSink& out) {
+    SoundingNote& s = sounding_[note & 0x7F];
+    if (s.holds == 0) return;
+    // Only the last lane to let go sends the note-off.
+    if (--s.holds == 0) out.push(BeatEvent{i, note, 0, false});
+}
+
+void BeatEngine::releaseLane(int i, BeatEventSink& out) {
+    const size_t lane = static_cast<size_t>(i);
+    if (clocks_.offTick[lane] == 0) return;
+    noteOff(i, beats_[lane].noteOff_, out);
+    clocks_.offTick[lane] = 0;
+    noteOffs_.cancel(i);
+}
+
+void BeatEngine::serviceLane(int i, int globalTick, BeatEventSink& out) {
+    Beat& b = beats_[static_cast<size_t>(i)];
+    const size_t lane = static_cast<size_t>(i);
+    if (b.updateNotes_) {
+        releaseLane(i, out);
+        b.rebuildNotes();
+    }
+    if (b.updatePattern_) {
+        releaseLane(i, out);
+        rebuildLanePattern(i);
+        // Pick the new pattern up where the song is, as if it had always been
+        // set, rather than restarting the lane mid-bar.
+        seekLane(i, std::max(0, globalTick));
+    }
+
+    if (b.effectiveMute()) {
+        if (!b.muted_) {
+            b.muted_ = true;
+            releaseLane(i, out);
+        }
+        classifyLane(i);
+        return;
+    }
+    b.muted_ = false;
+    classifyLane(i);
+
+    const bool offDue = clocks_.offTick[lane] != 0 && globalTick >= clocks_.offTick[lane];
+    clocks_.countdown[lane] -= 1;
+    stepLane(i, offDue, clocks_.countdown[lane] <= 0, globalTick, out);
+}
+
+void BeatEngine::stepLane(int i, bool offDue, bool fire, int globalTick, BeatEventSink& out) {
+    const Beat& b = beats_[static_cast<size_t>(i)];
+    const size_t lane = static_cast<size_t>(i);
+    if (offDue) releaseLane(i, out);
+    if (!fire) return;
+
+    // Reset the countdown for the next step.
+    clocks_.countdown[lane] = clocks_.stepTicks[lane];
+    if (laneHit(i, clocks_.step[lane])) {
+        // A gate longer than the step is still holding the previous note; end it
+        // before retriggering so every note-on gets exactly one note-off.
+        releaseLane(i, out);
+        noteOn(i, b.noteOn_, static_cast<uint8_t>(b.params_.loud), globalTick, out);
+        clocks_.offTick[lane] = globalTick + b.sustainTicks_;
+        noteOffs_.schedule(i, clocks_.offTick[lane]);
     }
+    clocks_.step[lane] += 1;
+    if (clocks_.step[lane] >= clocks_.length[lane]) clocks_.step[lane] = 0;
 }
 
-void BeatEngine::processTick(int globalTick, std::vector<BeatEvent>& out) {
+void BeatEngine::processTick(int globalTick, BeatEventSink& out) {
     if (muted_) return;
-    for (int i = 0; i < kMaxBeats; ++i) {
-        const bool soloGate = anySolo_ && !laneSolo_[static_cast<size_t>(i)];
-        beats_[static_cast<size_t>(i)].setExternalMute(laneMute_[static_cast<size_t>(i)] || soloGate);
-        beats_[static_cast<size_t>(i)].tick(globalTick, out);
+    out.setTick(globalTick);
+
+    // Batched countdown over each group of lanes that has a running lane; the
+    // compiler vectorises the fixed-length inner loop, and the results collapse
+    // to a lane mask. An idle group costs one mask test, so wide builds pay for
+    // the lanes in use rather than kMaxBeats.
+    const LaneMask run = runMask_;
+    const LaneMask service = serviceMask_;
+    LaneMask fire = 0;
+    for (int group = 0; group < kMaxBeats; group += kLaneGroup) {
+        if (((run >> group) & kLaneGroupMask) == 0) continue;
+        const int groupEnd = std::min(group + kLaneGroup, kMaxBeats);
+        for (int i = group; i < groupEnd; ++i) {
+            const size_t lane = static_cast<size_t>(i);
+            clocks_.countdown[lane] -= static_cast<int32_t>((run >> i) & 1u);
+            fire |= static_cast<LaneMask>(clocks_.countdown[lane] <= 0) << i;
+        }
+    }
+    // Due note-offs come off the heap; service lanes check their own.
+    LaneMask offDue = 0;
+    while (!noteOffs_.empty() && noteOffs_.top().tick <= globalTick) {
+        offDue |= LaneMask{1} << noteOffs_.top().lane;
+        noteOffs_.pop();
+    }
+    offDue &= run;
+    fire &= run;
+
+    // Only lanes with something to do take the branchy path, in lane order.
+    LaneMask pending = service | offDue | fire;
+    while (pending != 0) {
+        const int i = lowestLane(pending);
+        const LaneMask bit = LaneMask{1} << i;
+        pending &= pending - 1;
+        if (service & bit) {
+            serviceLane(i, globalTick, out);
+        } else {
+            stepLane(i, (offDue & bit) != 0, (fire & bit) != 0, globalTick, out);
+        }
+    }
+}
+
+int BeatEngine::processRange(int firstTick, int endTick, BeatEventSink& out) {
+    int tick = firstTick;
+    while (tick < endTick && out.hasRoomForTick()) {
+        // Horizon is measured from the last tick run.
+        const int ahead = ticksUntilNextEvent(tick - 1);
+        if (ahead > endTick - tick) {
+            skipTicks(endTick - tick);
+            return endTick;
+        }
+        skipTicks(ahead - 1);
+        tick += ahead - 1;
+        processTick(tick, out);
+        ++tick;
+    }
+    return tick;
+}
+
+int BeatEngine::laneTicksUntilEvent(int i, int globalTick) const {
+    const LaneMask bit = LaneMask{1} << i;
+    if (serviceMask_ & bit) return 1;
+    if (!(runMask_ & bit)) return kNoPendingEvent;
+
+    const size_t lane = static_cast<size_t>(i);
+    int next = kNoPendingEvent;
+    if (clocks_.offTick[lane] != 0) next = std::max(1, clocks_.offTick[lane] - globalTick);
+
+    // Walk the pattern from the current step to the next hit; silent steps only move the index.
+    const int length = clocks_.length[lane];
+    int ticks = std::max(1, clocks_.countdown[lane]);
+    for (int k = 0; k < length && ticks < next; ++k) {
+        if (laneHit(i, (clocks_.step[lane] + k) % length)) {
+            next = ticks;
+            break;
+        }
+        ticks += clocks_.stepTicks[lane];
+    }
+    return next;
+}
+
+void BeatEngine::skipLaneTicks(int i, int count) {
+    const size_t lane = static_cast<size_t>(i);
+    const int firstStep = std::max(1, clocks_.countdown[lane]);
+    if (count < firstStep) {
+        clocks_.countdown[lane] -= count;
+        return;
     }
+    const int stepTicks = clocks_.stepTicks[lane];
+    const int afterFirst = count - firstStep;
+    const int stepsCrossed = 1 + afterFirst / stepTicks;
+    clocks_.countdown[lane] = stepTicks - (afterFirst % stepTicks);
+    const int length = clocks_.length[lane];
+    clocks_.step[lane] = length > 0 ? (clocks_.step[lane] + stepsCrossed) % length : 0;
 }
 
-void BeatEngine::purgeAll(std::vector<BeatEvent>& out) {
-    for (auto& b : beats_) {
-        BeatEvent ev{};
-        ev.beatIndex = b.params().noteIndex; // store index for visibility, not critical
-        ev.note = noteIndexToMidi(b.params().octave, b.params().noteIndex);
-        ev.velocity = 0;
-        ev.noteOn = false;
+void BeatEngine::eventsInRange(int firstTick, int endTick, std::vector<BeatEvent>& out) const {
+    if (muted_ || endTick <= firstTick) return;
+    // Each lane's own notes, plus what each lane is still holding at firstTick,
+    // then the same pitch sharing noteOn()/noteOff() apply, on a local copy.
+    std::array<SoundingNote, 128> sounding{};
+    std::vector<BeatEvent> laneEvents;
+    for (int i = 0; i < kMaxBeats; ++i) {
+        const Beat& b = beats_[static_cast<size_t>(i)];
+        const int held = b.heldHitBefore(firstTick);
+        if (held >= 0) {
+            SoundingNote& s = sounding[b.pitch() & 0x7F];
+            ++s.holds;
+            s.lane = static_cast<int8_t>(i);
+            s.struckAt = held;
+        }
+        b.eventsInRange(firstTick, endTick, laneEvents);
+    }
+    // Lanes were added in order and each is in tick order, so a stable sort on
+    // tick gives processTick's order: by lane within a tick, note-off first.
+    std::stable_sort(laneEvents.begin(), laneEvents.end(),
+                     [](const BeatEvent& a, const BeatEvent& b) { return a.tick < b.tick; });
+    for (const BeatEvent& ev : laneEvents) {
+        SoundingNote& s = sounding[ev.note & 0x7F];
+        if (!ev.noteOn) {
+            if (s.holds > 0 && --s.holds == 0) out.push_back(ev);
+            continue;
+        }
+        if (s.holds > 0) {
+            if (s.struckAt == ev.tick) {
+                ++s.holds;
+                BeatEvent shared = ev;
+                shared.coalesced = true;
+                out.push_back(shared);
+                continue;
+            }
+            out.push_back(BeatEvent{ev.beatIndex, ev.note, 0, false, ev.tick});
+        }
+        ++s.holds;
+        s.lane = static_cast<int8_t>(ev.beatIndex);
+        s.struckAt = ev.tick;
         out.push_back(ev);
     }
 }
 
-void BeatEngine::resetTiming() {
-    for (auto& b : beats_) {
-        b.resetTiming();
+int BeatEngine::ticksUntilNextEvent(int globalTick) const {
+    if (muted_) return kNoPendingEvent;
+    int next = kNoPendingEvent;
+    for (LaneMask lanes = runMask_ | serviceMask_; lanes != 0; lanes &= lanes - 1) {
+        next = std::min(next, laneTicksUntilEvent(lowestLane(lanes), globalTick));
     }
+    return next;
 }
 
-} // namespace beatvst
+void BeatEngine::skipTicks(int count) {
+    if (muted_ || count <= 0) return;
+    for (LaneMask lanes = runMask_; lanes != 0; lanes &= lanes - 1) {
+        skipLaneTicks(lowestLane(lanes), count);
+    }
+}
+
+void BeatEngine::purgeAll(BeatEventSink& out) {
+    // Note-offs for exactly the pitches still sounding.
+    for (size_t note = 0; note < sounding_.size(); ++note) {
+        SoundingNote& s = sounding_[note];
+        if (s.holds == 0) continue;
+        out.push(BeatEvent{s.lane, static_cast<uint8_t>(note), 0, false});
+        s = SoundingNote{};
+    }
+    clocks_.offTick.fill(0);
+    noteOffs_.clear();
+}
 
+void BeatEngine::seek(int tick) {
+    clocks_.offTick.fill(0);
+    noteOffs_.clear();
+    sounding_.fill(SoundingNote{});
+    for (int i = 0; i < kMaxBeats; ++i) {
+        Beat& b = beats_[static_cast<size_t>(i)];
+        if (b.updateNotes_) b.rebuildNotes();
+        if (b.updatePattern_) rebuildLanePattern(i);
+        // Nothing is sounding, so a muted lane has no note-off left to send.
+        b.muted_ = b.effectiveMute();
+        seekLane(i, std::max(0, tick));
+        classifyLane(i);
+    }
+}
+
+void BeatEngine::seekLane(int i, int tick) {
+    // From tick 0 a lane fires step k at tick (k + 1) * stepTicks, the first step
+    // coming one step in. Count the steps fired before tick and the countdown
+    // that makes the next one land on time.
+    const size_t lane = static_cast<size_t>(i);
+    const int stepTicks = clocks_.stepTicks[lane];
+    const int length = clocks_.length[lane];
+    const int fired = tick > 0 ? (tick - 1) / stepTicks : 0;
+    clocks_.step[lane] = length > 0 ? fired % length : 0;
+    clocks_.countdown[lane] = (fired + 1) * stepTicks - tick + 1;
+}
+
+} // namespace beatvst
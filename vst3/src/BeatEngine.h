@@ -3,22 +3,140 @@
 #pragma once
 
 #include <array>
+#include <climits>
 #include <cstdint>
 #include <optional>
+#include <type_traits>
 #include <vector>
 
+// Tick resolution of the engine clock in pulses per quarter note. Override at
+// build time (e.g. -DBEAT_TICKS_PER_QUARTER=960) for a high-resolution variant.
+#ifndef BEAT_TICKS_PER_QUARTER
+#define BEAT_TICKS_PER_QUARTER 24
+#endif
+
+// Number of lanes. The parameter layout, saved state and editor lane range are
+// derived from it, so a build with a different count is a different plugin
+// layout (e.g. -DBEAT_MAX_LANES=32 for a dense percussion build).
+#ifndef BEAT_MAX_LANES
+#define BEAT_MAX_LANES 8
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace beatvst {
 
-constexpr int kMaxBeats = 8;
+constexpr int kTicksPerQuarter = BEAT_TICKS_PER_QUARTER;
+static_assert(kTicksPerQuarter >= 12 && kTicksPerQuarter % 12 == 0,
+              "BEAT_TICKS_PER_QUARTER must be a positive multiple of 12");
+
+constexpr int kMaxBeats = BEAT_MAX_LANES;
+static_assert(kMaxBeats >= 1 && kMaxBeats <= 64, "BEAT_MAX_LANES must be between 1 and 64");
 constexpr int kMaxLoopLength = 32;
 constexpr int kMinOctave = -1;
 constexpr int kMaxOctave = 9;
+// Gate lengths are counted on a fixed 24 PPQ grid (6 = a sixteenth) so stored
+// values do not depend on BEAT_TICKS_PER_QUARTER. The longest gate is four 4/4 bars.
+constexpr int kGateTicksPerQuarter = 24;
+constexpr int kMaxGate = 16 * kGateTicksPerQuarter;
+constexpr int kDefaultGate = kGateTicksPerQuarter / 4;
+// Returned by the event-horizon queries when nothing will happen until a parameter changes.
+constexpr int kNoPendingEvent = INT_MAX;
+
+// One bit per lane.
+using BeatLaneMask = std::conditional_t<(kMaxBeats <= 32), uint32_t, uint64_t>;
+
+// Index of the lowest set bit; mask must be non-zero.
+inline int lowestLane(BeatLaneMask mask) {
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    if constexpr (sizeof(BeatLaneMask) == 8) {
+        _BitScanForward64(&index, mask);
+    } else {
+        _BitScanForward(&index, static_cast<unsigned long>(mask));
+    }
+    return static_cast<int>(index);
+#else
+    if constexpr (sizeof(BeatLaneMask) == 8) {
+        return __builtin_ctzll(mask);
+    } else {
+        return __builtin_ctz(mask);
+    }
+#endif
+}
 
 struct BeatEvent {
     int beatIndex{};
     uint8_t note{};
     uint8_t velocity{};
     bool noteOn{};
+    int tick{};  // engine tick that produced the event
+    // A lane hit on a pitch another lane already struck this tick. It marks the
+    // lane's hit but must not be sent as MIDI.
+    bool coalesced{};
+};
+
+// Fixed-capacity event buffer filled on the audio thread, so it never allocates.
+// Holds many ticks' worth of events; processRange stops early rather than overflow.
+class BeatEventSink {
+public:
+    // Worst case for one tick: per lane, its own note-off, the note-off that ends
+    // another lane's voice on the same pitch, and the note-on.
+    static constexpr int kTickCapacity = kMaxBeats * 3;
+    static constexpr int kCapacity = kTickCapacity * 16;
+
+    void clear() { size_ = 0; }
+    // Tick stamped on subsequent pushes.
+    void setTick(int tick) { tick_ = tick; }
+    bool push(BeatEvent ev) {
+        if (size_ >= kCapacity) return false;
+        ev.tick = tick_;
+        events_[static_cast<size_t>(size_++)] = ev;
+        return true;
+    }
+    bool hasRoomForTick() const { return size_ <= kCapacity - kTickCapacity; }
+    int size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const BeatEvent* begin() const { return events_.data(); }
+    const BeatEvent* end() const { return events_.data() + size_; }
+
+private:
+    std::array<BeatEvent, kCapacity> events_{};
+    int size_{0};
+    int tick_{0};
+};
+
+// Per-lane parameter slots. Bars through Loud follow the host parameter layout;
+// later slots have their own ID blocks (see BeatIDs.h) so existing IDs stay put.
+enum BeatParamSlot {
+    kSlotBars = 0,
+    kSlotLoop,
+    kSlotBeats,
+    kSlotRotate,
+    kSlotNoteIndex,
+    kSlotOctave,
+    kSlotLoud,
+    kSlotGate,
+    kBeatParamSlotCount
+};
+
+struct BeatParamRange {
+    int min;
+    int max;
+};
+
+// Plain value range of each BeatParamSlot.
+constexpr BeatParamRange kBeatParamRanges[kBeatParamSlotCount] = {
+    {1, kMaxLoopLength},      // Bars
+    {1, kMaxLoopLength},      // Loop
+    {0, kMaxLoopLength},      // Beats
+    {0, kMaxLoopLength},      // Rotate
+    {0, 11},                  // NoteIndex
+    {kMinOctave, kMaxOctave}, // Octave
+    {0, 127},                 // Loud
+    {1, kMaxGate},            // Gate
 };
 
 struct BeatParams {
@@ -29,27 +147,64 @@ struct BeatParams {
     int octave{2};
     int noteIndex{0};
     int loud{0};
+    int gate{kDefaultGate};
 };
 
+// Pending note-offs as a min-heap on tick, holding at most one entry per lane.
+// Storage is fixed, so scheduling and cancelling never allocate.
+class NoteOffQueue {
+public:
+    struct Entry {
+        int32_t tick;
+        int32_t lane;
+    };
+
+    NoteOffQueue() { position_.fill(-1); }
+    bool empty() const { return size_ == 0; }
+    const Entry& top() const { return heap_[0]; }
+    // Adds the lane's note-off, replacing any it already has.
+    void schedule(int lane, int tick);
+    void cancel(int lane);
+    void pop();
+    void clear();
+
+private:
+    std::array<Entry, kMaxBeats> heap_{};
+    std::array<int, kMaxBeats> position_{};  // heap index per lane, -1 when none pending
+    int size_{0};
+
+    void place(int index, const Entry& entry);
+    void siftUp(int index);
+    void siftDown(int index);
+    void removeAt(int index);
+};
+
+uint8_t noteIndexToMidi(int octave, int noteIndex);
+
+// Per-lane parameters and control state. The lane's clock (countdown, step,
+// pattern, pending note-off) lives in BeatEngine's structure-of-arrays so the
+// per-tick work can run across all lanes at once.
 class Beat {
 public:
     explicit Beat(int index = 0);
+    bool setParam(BeatParamSlot slot, int value);
+    // Name-based form kept for compatibility ("Bars", "Loop", ..., "Note"/"NoteIndex", "Loud", "Gate").
     bool setParam(const char* name, int value);
     void setParams(const BeatParams& p);
     void setExternalMute(bool muted) { externalMute_ = muted; }
-    void tick(int globalTick, std::vector<BeatEvent>& out);
     BeatParams params() const { return params_; }
-    void resetTiming();
+    // This lane's note-ons and note-offs in [firstTick, endTick) when playback
+    // runs from tick 0 (or a seek) with the current parameters, in tick order and
+    // ignoring other lanes. Worked out from the pattern and step length, so the
+    // cost follows the notes in the window rather than the ticks before it.
+    void eventsInRange(int firstTick, int endTick, std::vector<BeatEvent>& out) const;
 
 private:
+    friend class BeatEngine;
+
     int index_{};
     BeatParams params_{};
-    std::vector<int> truths_;
-    int truthIndex_{0};
-    int tickCountdown_{0};
-    int stepTicks_{1};
-    int sustainTicks_{6};
-    int offTick_{0};
+    int sustainTicks_{kDefaultGate * kTicksPerQuarter / kGateTicksPerQuarter};
     bool mute_{false};
     bool muted_{false};
     bool externalMute_{false};
@@ -58,9 +213,20 @@ private:
     uint8_t noteOn_{60};  // default middle C
     uint8_t noteOff_{60};
 
-    void rebuildPattern();
+    bool effectiveMute() const { return mute_ || externalMute_; }
+    // Steady-state shape of the lane, straight from params_.
+    int stepTicks() const;
+    uint32_t pattern() const;
+    uint8_t pitch() const { return noteIndexToMidi(params_.octave, params_.noteIndex); }
+    bool silent() const;
+    // Tick of the hit whose note is still held going into tick, -1 when none.
+    int heldHitBefore(int tick) const;
+    // Calls visit(hit, off) for each note struck before endTick and still held at firstTick or later.
+    template <typename Visit>
+    void forEachNote(int firstTick, int endTick, Visit visit) const;
     void rebuildNotes();
     void checkMute();
+    void updateSustain();
 };
 
 class BeatEngine {
@@ -69,24 +235,96 @@ public:
     void selectBeat(int oneBased);
     int selectedBeat() const { return selected_ + 1; }
     void setBeatParam(const char* name, int value);
+    void setLaneParam(int beatIndex, BeatParamSlot slot, int value);
+    // Plain value of one lane parameter as last set; 0 for an unknown lane or slot.
+    int laneParam(int beatIndex, BeatParamSlot slot) const;
     void setLaneMute(int beatIndex, bool muted);
     void setLaneSolo(int beatIndex, bool solo);
     void setMuted(bool muted) { muted_ = muted; }
     BeatParams getBeatParams(int idx) const { return beats_[idx].params(); }
-    void resetTiming();
-    void processTick(int globalTick, std::vector<BeatEvent>& out);
-    void purgeAll(std::vector<BeatEvent>& out);
+    // Puts every lane where it would be before tick if playback had run from
+    // tick 0 with the current parameters, in O(1) per lane, with no note
+    // sounding. Negative ticks seek to 0. Only pending rebuilds are done.
+    void seek(int tick);
+    void processTick(int globalTick, BeatEventSink& out);
+    // Runs ticks firstTick..endTick-1, skipping silent stretches, and returns the
+    // first tick not run. That is endTick unless the sink filled up first.
+    int processRange(int firstTick, int endTick, BeatEventSink& out);
+    // The events processRange produces for [firstTick, endTick) after seek(0)
+    // with the current parameters, shared pitches included, computed without
+    // running or touching the engine. Safe to call from several threads at once
+    // while nothing changes the parameters.
+    void eventsInRange(int firstTick, int endTick, std::vector<BeatEvent>& out) const;
+    // Ticks from globalTick until the next processTick() that emits or changes state (>= 1).
+    int ticksUntilNextEvent(int globalTick) const;
+    // Advance over ticks that are known to be silent; count must be < ticksUntilNextEvent().
+    void skipTicks(int count);
+    void purgeAll(BeatEventSink& out);
 
 private:
-    std::array<Beat, kMaxBeats> beats_{};
+    using LaneMask = BeatLaneMask;
+    // Lanes are processed in groups of this many; groups with no running lane are skipped.
+    static constexpr int kLaneGroup = 8;
+    static constexpr LaneMask kLaneGroupMask = 0xFF;
+    static constexpr LaneMask kAllLanes = ~LaneMask{0} >> (sizeof(LaneMask) * 8 - kMaxBeats);
+
+    // Hot per-lane clock state as parallel arrays.
+    struct LaneClocks {
+        alignas(32) std::array<int32_t, kMaxBeats> countdown{};
+        alignas(32) std::array<int32_t, kMaxBeats> step{};
+        alignas(32) std::array<int32_t, kMaxBeats> stepTicks{};
+        alignas(32) std::array<int32_t, kMaxBeats> length{};
+        alignas(32) std::array<uint32_t, kMaxBeats> pattern{};  // bit i set = step i is a hit
+        alignas(32) std::array<int32_t, kMaxBeats> offTick{};
+    };
+
+    std::array<Beat, kMaxBeats> beats_;
+    LaneClocks clocks_{};
+    NoteOffQueue noteOffs_;
+
+    // Sounding pitches and how many lanes hold each, so lanes that share a pitch
+    // produce one balanced on/off stream.
+    struct SoundingNote {
+        uint8_t holds;
+        int8_t lane;       // lane that struck it last
+        int32_t struckAt;  // tick of that strike
+    };
+    std::array<SoundingNote, 128> sounding_{};
+    LaneMask runMask_{0};      // lanes advanced by the batched countdown
+    LaneMask serviceMask_{0};  // lanes with a pending rebuild or mute transition
     int selected_{0};
     bool muted_{false};
-    std::array<bool, kMaxBeats> laneMute_{};
-    std::array<bool, kMaxBeats> laneSolo_{};
-    bool anySolo_{false};
+    LaneMask laneMuteMask_{0};
+    LaneMask laneSoloMask_{0};
+    LaneMask gateMask_{0};  // lanes silenced by their mute or by another lane's solo
+
+    void applyLaneGates();
+    void classifyLane(int i);
+    void rebuildLanePattern(int i);
+    void noteOn(int i, uint8_t note, uint8_t velocity, int tick, BeatEventSink& out);
+    void noteOff(int i, uint8_t note, BeatEventSink& out);
+    void releaseLane(int i, BeatEventSink& out);
+    void serviceLane(int i, int globalTick, BeatEventSink& out);
+    void stepLane(int i, bool offDue, bool fire, int globalTick, BeatEventSink& out);
+    bool laneHit(int i, int step) const;
+    int laneTicksUntilEvent(int i, int globalTick) const;
+    void skipLaneTicks(int i, int count);
+    void seekLane(int i, int tick);
 };
 
-uint8_t noteIndexToMidi(int octave, int noteIndex);
+// Rotates a loop-length step mask right by rotate steps (matches std::rotate on the step list).
+constexpr uint32_t rotatePattern(uint32_t mask, int loop, int rotate) {
+    if (loop <= 0) return 0;
+    const uint32_t full = loop >= 32 ? 0xFFFFFFFFu : ((1u << loop) - 1u);
+    int r = rotate % loop;
+    if (r < 0) r += loop;
+    mask &= full;
+    if (r == 0) return mask;
+    return ((mask << r) | (mask >> (loop - r))) & full;
+}
+
+// Euclidean pattern for loop steps and beats hits from the compile-time table; 0 when out of range.
+uint32_t euclideanPattern(int loop, int beats);
 
 } // namespace beatvst
 
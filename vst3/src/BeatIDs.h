@@ -30,6 +30,17 @@ constexpr const char kBeatVst3Build[] = __DATE__ " " __TIME__;
 constexpr Steinberg::FIDString kBeatVst3Url = "https://ableplugs.local/beat";
 constexpr Steinberg::FIDString kBeatVst3Email = "support@ableplugs.local";
 
+// Sent by the controller on each editor timer tick; the processor answers with
+// a kBeatActivityMessage holding the lanes to show lit (a BeatLaneMask).
+constexpr Steinberg::FIDString kBeatActivityPollMessage = "BeatActivityPoll";
+constexpr Steinberg::FIDString kBeatActivityMessage = "BeatActivity";
+constexpr const char kBeatActivityLitAttr[] = "Lit";
+
+// Sent by the controller after a state load: the state encoded as in
+// BeatState.h, for the processor to apply in one block.
+constexpr Steinberg::FIDString kBeatStateMessage = "BeatState";
+constexpr const char kBeatStateValuesAttr[] = "Values";
+
 enum ParamIDs : Steinberg::Vst::ParamID {
     kParamEffectEnabled = 0,
     kParamBeatSelect,
@@ -37,27 +48,18 @@ enum ParamIDs : Steinberg::Vst::ParamID {
     kParamBaseBeatParams // start of per-beat params, layout: beat * kPerBeatParams + param
 };
 
-constexpr int kPerBeatParams = 7; // Bars, Loop, Beats, Rotate, NoteIndex, Octave, Loud
+constexpr int kPerBeatParams = beatvst::kSlotGate; // Bars, Loop, Beats, Rotate, NoteIndex, Octave, Loud
 constexpr int kActiveParamBase = kParamBaseBeatParams + beatvst::kMaxBeats * kPerBeatParams;
 constexpr int kLaneMuteBase = kActiveParamBase + kPerBeatParams;
 constexpr int kLaneSoloBase = kLaneMuteBase + beatvst::kMaxBeats;
 constexpr int kLaneActivityBase = kLaneSoloBase + beatvst::kMaxBeats;
 constexpr Steinberg::Vst::ParamID kParamGlobalSolo = kLaneActivityBase + beatvst::kMaxBeats;
+constexpr int kLaneGateBase = kParamGlobalSolo + 1;
 
-inline Steinberg::Vst::ParamID beatParamId(int beatIndex, int paramSlot) {
+constexpr Steinberg::Vst::ParamID beatParamId(int beatIndex, int paramSlot) {
     return static_cast<Steinberg::Vst::ParamID>(kParamBaseBeatParams + beatIndex * kPerBeatParams + paramSlot);
 }
 
-enum BeatParamSlot {
-    kSlotBars = 0,
-    kSlotLoop,
-    kSlotBeats,
-    kSlotRotate,
-    kSlotNoteIndex,
-    kSlotOctave,
-    kSlotLoud
-};
-
 enum ActiveParamSlot {
     kActiveBars = 0,
     kActiveLoop,
@@ -68,19 +70,23 @@ enum ActiveParamSlot {
     kActiveLoud
 };
 
-inline Steinberg::Vst::ParamID activeParamId(int slot) {
+constexpr Steinberg::Vst::ParamID activeParamId(int slot) {
     return static_cast<Steinberg::Vst::ParamID>(kActiveParamBase + slot);
 }
 
-inline Steinberg::Vst::ParamID laneMuteParamId(int beatIndex) {
+constexpr Steinberg::Vst::ParamID laneMuteParamId(int beatIndex) {
     return static_cast<Steinberg::Vst::ParamID>(kLaneMuteBase + beatIndex);
 }
 
-inline Steinberg::Vst::ParamID laneSoloParamId(int beatIndex) {
+constexpr Steinberg::Vst::ParamID laneSoloParamId(int beatIndex) {
     return static_cast<Steinberg::Vst::ParamID>(kLaneSoloBase + beatIndex);
 }
 
-inline Steinberg::Vst::ParamID laneActivityParamId(int beatIndex) {
+constexpr Steinberg::Vst::ParamID laneActivityParamId(int beatIndex) {
     return static_cast<Steinberg::Vst::ParamID>(kLaneActivityBase + beatIndex);
 }
 
+constexpr Steinberg::Vst::ParamID laneGateParamId(int beatIndex) {
+    return static_cast<Steinberg::Vst::ParamID>(kLaneGateBase + beatIndex);
+}
+
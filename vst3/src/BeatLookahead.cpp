@@ -0,0 +1,128 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+#include "BeatLookahead.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace beatvst {
+
+namespace {
+
+// The audio thread wakes the worker without the mutex, so a wake can land
+// between the worker's check and its wait; this bounds how long that one is lost.
+constexpr auto kWakeBackstop = std::chrono::milliseconds(20);
+
+} // namespace
+
+void BeatLookahead::start(int aheadTicks) {
+    stop();
+    aheadTicks_ = std::max(aheadTicks, kChunkTicks);
+    // A full horizon, the chunk being read and the one being rendered.
+    capacity_ = static_cast<uint32_t>(aheadTicks_ / kChunkTicks + 2);
+    ring_ = std::make_unique<Chunk[]>(capacity_);
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+    playhead_.store(0, std::memory_order_relaxed);
+    start_.store(kStartIdle, std::memory_order_relaxed);
+    wake_.store(false, std::memory_order_relaxed);
+    sleeping_.store(false, std::memory_order_relaxed);
+    wakeAt_.store(kNoPendingEvent, std::memory_order_relaxed);
+    generation_ = 0;
+    running_.store(true, std::memory_order_release);
+    worker_ = std::thread(&BeatLookahead::run, this);
+}
+
+void BeatLookahead::stop() {
+    if (!worker_.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex_);
+        running_.store(false, std::memory_order_release);
+    }
+    wakeup_.notify_one();
+    worker_.join();
+    ring_.reset();
+    capacity_ = 0;
+}
+
+bool BeatLookahead::restart(const BeatEngine& engine, int tick) {
+    if (!running()) return false;
+    // A start the worker has not taken yet is simply replaced.
+    int expected = start_.load(std::memory_order_relaxed);
+    do {
+        if (expected == kStartTaking) return false;
+    } while (!start_.compare_exchange_weak(expected, kStartWriting, std::memory_order_acquire));
+    startEngine_ = engine;
+    startTick_ = tick;
+    startGeneration_ = ++generation_;
+    start_.store(kStartReady, std::memory_order_release);
+    wake();
+    return true;
+}
+
+const BeatLookahead::Chunk* BeatLookahead::chunkAt(int tick) {
+    if (!running()) return nullptr;
+    const uint32_t head = head_.load(std::memory_order_acquire);
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+    for (; tail != head; ++tail) {
+        const Chunk& chunk = slot(tail);
+        if (chunk.generation != generation_ || chunk.endTick < tick) continue;
+        // Once the next chunk is in, the one ending at tick is no longer needed.
+        if (chunk.endTick == tick && tail + 1 != head && slot(tail + 1).generation == generation_) continue;
+        break;
+    }
+    if (tail != tail_.load(std::memory_order_relaxed)) {
+        tail_.store(tail, std::memory_order_release);
+        wake();
+    }
+    if (tail == head) return nullptr;
+    const Chunk& chunk = slot(tail);
+    return chunk.firstTick <= tick ? &chunk : nullptr;
+}
+
+void BeatLookahead::run() {
+    int tick = 0;
+    uint32_t generation = 0;
+    bool started = false;
+    while (running_.load(std::memory_order_acquire)) {
+        int expected = kStartReady;
+        if (start_.compare_exchange_strong(expected, kStartTaking, std::memory_order_acquire)) {
+            engine_ = startEngine_;
+            tick = startTick_;
+            generation = startGeneration_;
+            started = true;
+            start_.store(kStartIdle, std::memory_order_release);
+        }
+
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        const bool full = head - tail_.load(std::memory_order_acquire) >= capacity_;
+        const int64_t horizon = static_cast<int64_t>(playhead_.load(std::memory_order_relaxed)) + aheadTicks_;
+        if (!started || full || tick >= horizon || tick >= kNoPendingEvent) {
+            // Held back only by the horizon: the playhead that moves it past tick.
+            const bool waitingForPlayhead = started && !full && tick < kNoPendingEvent;
+            wakeAt_.store(waitingForPlayhead ? tick - aheadTicks_ + 1 : kNoPendingEvent, std::memory_order_relaxed);
+            sleeping_.store(true, std::memory_order_seq_cst);
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex_);
+                wakeup_.wait_for(lock, kWakeBackstop, [this] {
+                    return wake_.exchange(false, std::memory_order_seq_cst) || !running_.load(std::memory_order_acquire);
+                });
+            }
+            sleeping_.store(false, std::memory_order_relaxed);
+            wakeAt_.store(kNoPendingEvent, std::memory_order_relaxed);
+            continue;
+        }
+
+        Chunk& chunk = slot(head);
+        chunk.generation = generation;
+        chunk.firstTick = tick;
+        chunk.start = engine_;
+        chunk.events.clear();
+        tick = engine_.processRange(tick, static_cast<int>(std::min<int64_t>(int64_t{tick} + kChunkTicks, kNoPendingEvent)),
+                                    chunk.events);
+        chunk.endTick = tick;
+        head_.store(head + 1, std::memory_order_release);
+    }
+}
+
+} // namespace beatvst
@@ -0,0 +1,122 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+#pragma once
+
+#include "BeatEngine.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+// Beats the lookahead worker renders ahead of playback; 0 leaves it off and
+// every block renders inline (e.g. -DBEAT_LOOKAHEAD_BEATS=4).
+#ifndef BEAT_LOOKAHEAD_BEATS
+#define BEAT_LOOKAHEAD_BEATS 0
+#endif
+
+namespace beatvst {
+
+constexpr int kLookaheadBeats = BEAT_LOOKAHEAD_BEATS;
+static_assert(kLookaheadBeats >= 0 && kLookaheadBeats <= 64, "BEAT_LOOKAHEAD_BEATS must be between 0 and 64");
+
+// Renders engine events ahead of playback on a worker thread. The audio thread
+// hands over an engine and the tick it stands before; the worker runs its own
+// copy forward a chunk at a time and passes the chunks back through a
+// single-producer/single-consumer ring. Each chunk keeps the engine it started
+// from, so the audio thread can take over at any tick by running at most one
+// chunk. The audio thread never waits; the worker sleeps until the audio
+// thread moves the playhead far enough to open a chunk, frees a chunk or hands
+// it a new start.
+class BeatLookahead {
+public:
+    // Ticks per chunk: a sixteenth, or less when the events fill the sink.
+    static constexpr int kChunkTicks = kTicksPerQuarter / 4;
+
+    struct Chunk {
+        uint32_t generation{0};
+        int firstTick{0};
+        int endTick{0};     // first tick not rendered
+        BeatEngine start;   // engine state before firstTick
+        BeatEventSink events;
+    };
+
+    BeatLookahead() = default;
+    ~BeatLookahead() { stop(); }
+    BeatLookahead(const BeatLookahead&) = delete;
+    BeatLookahead& operator=(const BeatLookahead&) = delete;
+
+    // Allocates the ring and starts the worker; not for the audio thread.
+    void start(int aheadTicks);
+    void stop();
+    bool running() const { return worker_.joinable(); }
+
+    // Audio thread. Hands the worker engine as it stands before tick and
+    // discards everything rendered from earlier starts. Returns false, changing
+    // nothing, while the worker is picking up the previous start.
+    bool restart(const BeatEngine& engine, int tick);
+    // Audio thread. The next tick playback needs; the worker stays up to
+    // aheadTicks past it.
+    void setPlayhead(int tick) {
+        playhead_.store(tick, std::memory_order_relaxed);
+        if (tick >= wakeAt_.load(std::memory_order_relaxed)) wake();
+    }
+    // Audio thread. The chunk of the latest start holding tick or, until the
+    // next one is rendered, the one ending at tick; nullptr when there is
+    // neither. Chunks that end before tick go back to the worker, so tick must
+    // not move backwards within one start.
+    const Chunk* chunkAt(int tick);
+
+private:
+    void run();
+    // Audio thread. Never takes wakeMutex_, so it cannot block on the worker,
+    // and only makes the wake-up call when the worker is asleep.
+    void wake() {
+        wake_.store(true, std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_seq_cst)) wakeup_.notify_one();
+    }
+    Chunk& slot(uint32_t index) const { return ring_[index % capacity_]; }
+
+    std::unique_ptr<Chunk[]> ring_;
+    uint32_t capacity_{0};
+    int aheadTicks_{0};
+    std::atomic<uint32_t> head_{0};  // chunks rendered; worker writes
+    std::atomic<uint32_t> tail_{0};  // chunks released; audio thread writes
+    std::atomic<int> playhead_{0};
+    std::atomic<bool> running_{false};
+    uint32_t generation_{0};  // audio thread: the latest start
+    BeatEngine engine_;       // worker: the running copy
+    std::thread worker_;
+    std::mutex wakeMutex_;  // worker and stop() only
+    std::condition_variable wakeup_;
+    std::atomic<bool> wake_{false};
+    std::atomic<bool> sleeping_{false};  // worker is in, or about to enter, its wait
+    std::atomic<int> wakeAt_{kNoPendingEvent};  // playhead that gives the sleeping worker a chunk to render
+
+    // The latest start, handed over whole like BeatProcessor's state mailbox.
+    enum StartMailbox { kStartIdle, kStartWriting, kStartReady, kStartTaking };
+    BeatEngine startEngine_;
+    int startTick_{0};
+    uint32_t startGeneration_{0};
+    std::atomic<int> start_{kStartIdle};
+};
+
+// Stands in for BeatLookahead when kLookaheadBeats is 0: never running, so a
+// processor built without lookahead carries no ring, worker or engine copies.
+class BeatNoLookahead {
+public:
+    using Chunk = BeatLookahead::Chunk;
+    void start(int) {}
+    void stop() {}
+    bool running() const { return false; }
+    bool restart(const BeatEngine&, int) { return false; }
+    void setPlayhead(int) {}
+    const Chunk* chunkAt(int) { return nullptr; }
+};
+
+using BeatLookaheadMember = std::conditional_t<(kLookaheadBeats > 0), BeatLookahead, BeatNoLookahead>;
+
+} // namespace beatvst
@@ -0,0 +1,152 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+#pragma once
+
+#include "BeatIDs.h"
+#include "BeatState.h"
+
+#include "pluginterfaces/vst/ivsteditcontroller.h"
+
+#include <array>
+#include <cstdint>
+
+namespace beatvst {
+
+// One host parameter. Every parameter is an integer quantity.
+struct BeatParamDesc {
+    const char* name{""};   // title, after "Lane N " for lane params
+    int8_t lane{-1};        // -1 for params that belong to no lane
+    int16_t min{0};
+    int16_t max{1};
+    int16_t def{0};         // plain default
+    Steinberg::int32 flags{Steinberg::Vst::ParameterInfo::kCanAutomate};
+    int16_t stateIndex{-1}; // position in the saved state (BeatState.h), -1 when not saved
+};
+
+// Parameter IDs are dense, so the table is indexed by ID.
+constexpr int kParamCount = kLaneGateBase + kMaxBeats;
+
+namespace detail {
+
+constexpr BeatParamDesc describeParam(const char* name, int lane, BeatParamRange range, int def, int stateIndex) {
+    BeatParamDesc d;
+    d.name = name;
+    d.lane = static_cast<int8_t>(lane);
+    d.min = static_cast<int16_t>(range.min);
+    d.max = static_cast<int16_t>(range.max);
+    d.def = static_cast<int16_t>(def);
+    d.stateIndex = static_cast<int16_t>(stateIndex);
+    return d;
+}
+
+constexpr std::array<BeatParamDesc, kParamCount> makeParamTable() {
+    using Steinberg::Vst::ParameterInfo;
+    constexpr BeatParamRange kSwitch{0, 1};
+    constexpr const char* kSlotNames[] = {"Bars", "Loop", "Beats", "Rotate", "Note", "Octave", "Loud"};
+    constexpr const char* kActiveNames[] = {"Bars", "Loop", "Beats", "Rotate", "NoteIndex", "Octave", "Loud"};
+    const BeatParams defaults{};
+    const int slotDefaults[] = {defaults.bars, defaults.loop, defaults.beats, defaults.rotate,
+                                defaults.noteIndex, defaults.octave, defaults.loud};
+
+    std::array<BeatParamDesc, kParamCount> t{};
+    t[kParamEffectEnabled] = describeParam("Mute All", -1, kSwitch, 0, kStateMuteAll);
+    t[kParamBeatSelect] = describeParam("Beat Select", -1, {1, kMaxBeats}, 1, kStateBeatSelect);
+    t[kParamReset] = describeParam("Reset", -1, kSwitch, 0, -1);
+    t[kParamGlobalSolo] = describeParam("Global Solo", -1, kSwitch, 0, kStateGlobalSolo);
+    // The editor's section for the selected lane; mirrors that lane's params.
+    for (int slot = 0; slot < kPerBeatParams; ++slot) {
+        BeatParamDesc& d = t[activeParamId(slot)];
+        d = describeParam(kActiveNames[slot], -1, kBeatParamRanges[slot], slotDefaults[slot], -1);
+        d.flags |= ParameterInfo::kIsHidden;
+    }
+    for (int lane = 0; lane < kMaxBeats; ++lane) {
+        for (int slot = 0; slot < kPerBeatParams; ++slot) {
+            // Lanes start on consecutive notes.
+            const int def = slot == kSlotNoteIndex ? lane % 12 : slotDefaults[slot];
+            t[beatParamId(lane, slot)] =
+                describeParam(kSlotNames[slot], lane, kBeatParamRanges[slot], def, stateLaneIndex(lane, slot));
+        }
+        t[laneGateParamId(lane)] = describeParam("Gate", lane, kBeatParamRanges[kSlotGate], kDefaultGate, stateGateIndex(lane));
+        t[laneMuteParamId(lane)] = describeParam("Mute", lane, kSwitch, 0, stateLaneIndex(lane, kStateLaneMute));
+        t[laneSoloParamId(lane)] = describeParam("Solo", lane, kSwitch, 0, stateLaneIndex(lane, kStateLaneSolo));
+        // Set by the controller from the activity channel; never automated.
+        BeatParamDesc& activity = t[laneActivityParamId(lane)];
+        activity = describeParam("Activity", lane, kSwitch, 0, -1);
+        activity.flags = ParameterInfo::kIsReadOnly | ParameterInfo::kIsHidden;
+    }
+    return t;
+}
+
+// Order the controller registers params in, which hosts list them by.
+constexpr std::array<Steinberg::Vst::ParamID, kParamCount> makeRegistrationOrder() {
+    std::array<Steinberg::Vst::ParamID, kParamCount> order{};
+    size_t n = 0;
+    order[n++] = kParamEffectEnabled;
+    order[n++] = kParamGlobalSolo;
+    order[n++] = kParamBeatSelect;
+    order[n++] = kParamReset;
+    for (int slot = 0; slot < kPerBeatParams; ++slot) order[n++] = activeParamId(slot);
+    for (int lane = 0; lane < kMaxBeats; ++lane) {
+        for (int slot = 0; slot < kPerBeatParams; ++slot) order[n++] = beatParamId(lane, slot);
+        order[n++] = laneGateParamId(lane);
+        order[n++] = laneMuteParamId(lane);
+        order[n++] = laneSoloParamId(lane);
+        order[n++] = laneActivityParamId(lane);
+    }
+    return order;
+}
+
+constexpr std::array<Steinberg::Vst::ParamID, kStateValueCount> makeStateOrder(
+    const std::array<BeatParamDesc, kParamCount>& table) {
+    std::array<Steinberg::Vst::ParamID, kStateValueCount> order{};
+    for (int pid = 0; pid < kParamCount; ++pid) {
+        const int index = table[static_cast<size_t>(pid)].stateIndex;
+        if (index >= 0) order[static_cast<size_t>(index)] = static_cast<Steinberg::Vst::ParamID>(pid);
+    }
+    return order;
+}
+
+constexpr std::array<Steinberg::Vst::ParamValue, kStateValueCount> makeStateDefaults(
+    const std::array<BeatParamDesc, kParamCount>& table) {
+    std::array<Steinberg::Vst::ParamValue, kStateValueCount> values{};
+    for (const BeatParamDesc& d : table) {
+        if (d.stateIndex < 0) continue;
+        values[static_cast<size_t>(d.stateIndex)] =
+            d.max > d.min ? static_cast<Steinberg::Vst::ParamValue>(d.def - d.min) / (d.max - d.min) : 0.0;
+    }
+    return values;
+}
+
+constexpr bool everyParamDescribed(const std::array<BeatParamDesc, kParamCount>& table) {
+    for (const BeatParamDesc& d : table) {
+        if (d.name[0] == '\0') return false;
+    }
+    return true;
+}
+
+} // namespace detail
+
+inline constexpr std::array<BeatParamDesc, kParamCount> kParamTable = detail::makeParamTable();
+inline constexpr std::array<Steinberg::Vst::ParamID, kParamCount> kParamRegistrationOrder = detail::makeRegistrationOrder();
+// Param ID of each saved state value.
+inline constexpr std::array<Steinberg::Vst::ParamID, kStateValueCount> kStateParamIds = detail::makeStateOrder(kParamTable);
+inline constexpr std::array<Steinberg::Vst::ParamValue, kStateValueCount> kStateDefaults = detail::makeStateDefaults(kParamTable);
+static_assert(detail::everyParamDescribed(kParamTable), "every parameter ID needs a descriptor");
+
+constexpr const BeatParamDesc* findParam(Steinberg::Vst::ParamID pid) {
+    return pid < static_cast<Steinberg::Vst::ParamID>(kParamCount) ? &kParamTable[pid] : nullptr;
+}
+
+// Position of pid in the saved state, -1 when it is not saved.
+constexpr int paramStateIndex(Steinberg::Vst::ParamID pid) {
+    const BeatParamDesc* d = findParam(pid);
+    return d ? d->stateIndex : -1;
+}
+
+constexpr Steinberg::Vst::ParamValue paramDefaultNormalized(Steinberg::Vst::ParamID pid) {
+    const BeatParamDesc* d = findParam(pid);
+    if (!d || d->max <= d->min) return 0.0;
+    return static_cast<Steinberg::Vst::ParamValue>(d->def - d->min) / (d->max - d->min);
+}
+
+} // namespace beatvst
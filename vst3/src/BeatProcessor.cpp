@@ -2,16 +2,18 @@
 // MIT License
 #include "BeatProcessor.h"
 
-#include "BeatController.h"
+#include "BeatStateStream.h"
 
-#include "base/source/fstreamer.h"
+#include "pluginterfaces/base/smartpointer.h"
+#include "pluginterfaces/vst/ivstmessage.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 #include "pluginterfaces/vst/ivstprocesscontext.h"
 #include "pluginterfaces/vst/ivstevents.h"
 
 #include <algorithm>
 #include <cmath>
-#include <unordered_map>
+#include <cstdint>
+#include <limits>
 #ifdef BEAT_DEBUG_NAME
 #include <fstream>
 #endif
@@ -22,21 +24,20 @@ using namespace Steinberg::Vst;
 
 namespace {
 
-void addOutputParamChange(IParameterChanges* changes, ParamID pid, ParamValue value, int32 sampleOffset) {
-    if (!changes) return;
-    int32 index = 0;
-    IParamValueQueue* queue = changes->addParameterData(pid, index);
-    if (!queue) return;
-    int32 pointIndex = 0;
-    queue->addPoint(sampleOffset, value, pointIndex);
-}
+// How long a lane's activity light stays lit after a note-on (two ticks at 24 PPQ).
+constexpr int kActivityHoldTicks = kTicksPerQuarter / 12;
+// Largest gap between the running clock and the host position that is corrected
+// as drift (a sixteenth); anything larger is a jump in the song position.
+constexpr double kMaxClockCorrectionTicks = kTicksPerQuarter / 4.0;
 
 } // namespace
 
+static_assert(std::atomic<ParamValue>::is_always_lock_free, "state values are shared with the audio thread");
+
 BeatProcessor::BeatProcessor() {
+    for (size_t i = 0; i < stateValues_.size(); ++i) stateValues_[i].store(kStateDefaults[i], std::memory_order_relaxed);
     setControllerClass(kBeatControllerUID);
     setProcessing(true);
-    buildParamOrder();
 }
 
 tresult PLUGIN_API BeatProcessor::initialize(FUnknown* context) {
@@ -55,6 +56,89 @@ tresult PLUGIN_API BeatProcessor::terminate() {
     return AudioEffect::terminate();
 }
 
+tresult PLUGIN_API BeatProcessor::notify(IMessage* message) {
+    if (!message) return kInvalidArgument;
+    if (FIDStringsEqual(message->getMessageID(), kBeatActivityPollMessage)) {
+        sendActivity();
+        return kResultOk;
+    }
+    if (!FIDStringsEqual(message->getMessageID(), kBeatStateMessage)) {
+        return AudioEffect::notify(message);
+    }
+    IAttributeList* attributes = message->getAttributes();
+    const void* data = nullptr;
+    uint32 size = 0;
+    if (!attributes || attributes->getBinary(kBeatStateValuesAttr, data, size) != kResultOk || !data) {
+        return kResultFalse;
+    }
+    receiveState(data, size);
+    return kResultOk;
+}
+
+tresult PLUGIN_API BeatProcessor::setActive(TBool state) {
+    tresult result = AudioEffect::setActive(state);
+    active_ = state != 0;
+    if (active_) {
+        lookaheadOn_ = false;
+        lookaheadStale_ = true;
+        // Offline rendering is not held to the block deadline, so it stays inline.
+        if (kLookaheadBeats > 0 && processSetup.processMode == kRealtime) {
+            lookahead_.start(kLookaheadBeats * kTicksPerQuarter);
+        }
+        return result;
+    }
+    // The transport may still be running when the processor comes back.
+    resumeEngine(playheadTick());
+    lookahead_.stop();
+    // process() no longer runs, so a state it has not picked up is applied here.
+    applyPendingState();
+    return result;
+}
+
+void BeatProcessor::receiveState(const void* data, uint32 size) {
+    std::array<double, kStateValueCount> values = kStateDefaults;
+    if (!decodeState(static_cast<const uint8_t*>(data), size, values.data())) return;
+    postState(values);
+}
+
+void BeatProcessor::postState(const std::array<ParamValue, kStateValueCount>& values) {
+    // A state not yet picked up is simply replaced.
+    const uint32_t seq = pendingSeq_.load(std::memory_order_relaxed);
+    pendingSeq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < values.size(); ++i) pendingValues_[i].store(values[i], std::memory_order_relaxed);
+    pendingSeq_.store(seq + 2, std::memory_order_release);
+
+    // Without an active audio thread there is nothing to race with.
+    if (!active_) applyPendingState();
+}
+
+// Tries once: a state the UI thread is still writing is picked up next block.
+void BeatProcessor::applyPendingState() {
+    const uint32_t seq = pendingSeq_.load(std::memory_order_acquire);
+    if ((seq & 1) != 0 || seq == appliedSeq_.load(std::memory_order_relaxed)) return;
+    for (size_t i = 0; i < takenValues_.size(); ++i) takenValues_[i] = pendingValues_[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (pendingSeq_.load(std::memory_order_relaxed) != seq) return;
+    for (size_t i = 0; i < takenValues_.size(); ++i) {
+        if (kStateParamIds[i] != kParamGlobalSolo) applyNormalizedParam(kStateParamIds[i], takenValues_[i]);
+    }
+    appliedSeq_.store(seq, std::memory_order_release);
+}
+
+// Answers the controller's poll; messages work across processes, so the lights
+// do not depend on where the host puts the editor.
+void BeatProcessor::sendActivity() {
+    if (!peerConnection) return;
+    IPtr<IMessage> message = owned(allocateMessage());
+    if (!message) return;
+    message->setMessageID(kBeatActivityMessage);
+    IAttributeList* attributes = message->getAttributes();
+    if (!attributes) return;
+    attributes->setInt(kBeatActivityLitAttr, static_cast<int64>(activity_.drain()));
+    sendMessage(message);
+}
+
 tresult PLUGIN_API BeatProcessor::setBusArrangements(SpeakerArrangement* inputs, int32 numIns,
                                                      SpeakerArrangement* outputs, int32 numOuts) {
     // 0 audio ins, 1 stereo audio out.
@@ -65,7 +149,6 @@ tresult PLUGIN_API BeatProcessor::setBusArrangements(SpeakerArrangement* inputs,
 
 tresult PLUGIN_API BeatProcessor::setupProcessing(ProcessSetup& setup) {
     sampleRate_ = setup.sampleRate;
-    buildParamOrder();
     return AudioEffect::setupProcessing(setup);
 }
 
@@ -74,6 +157,8 @@ tresult PLUGIN_API BeatProcessor::canProcessSampleSize(int32 symbolicSampleSize)
     return kResultFalse;
 }
 
+// Only changes that reach the engine call engineChanged(), and they call it
+// before touching engine_, which may still need bringing up to the playhead.
 void BeatProcessor::applyNormalizedParam(ParamID pid, ParamValue value) {
     auto normToInt = [&](double norm, int min, int max) -> int {
         double v = min + norm * (max - min);
@@ -84,36 +169,44 @@ void BeatProcessor::applyNormalizedParam(ParamID pid, ParamValue value) {
     if (pid == ParamIDs::kParamBeatSelect) {
         currentSelected_ = normToInt(value, 1, kMaxBeats);
         engine_.selectBeat(currentSelected_);
-        paramState_[pid] = value;
+        storeParam(pid, value);
         return;
     }
 
     if (pid == ParamIDs::kParamEffectEnabled) {
-        paramState_[pid] = value;
-        engine_.setMuted(value > 0.5);
         const bool muted = value > 0.5;
+        bool changed = (stateValues_[static_cast<size_t>(kStateMuteAll)].load(std::memory_order_relaxed) > 0.5) != muted;
+        for (bool laneMuted : laneMute_) changed = changed || laneMuted != muted;
+        if (changed) engineChanged();
+        storeParam(pid, value);
+        engine_.setMuted(muted);
         for (int b = 0; b < kMaxBeats; ++b) {
             laneMute_[static_cast<size_t>(b)] = muted;
             engine_.setLaneMute(b, muted);
-            paramState_[laneMuteParamId(b)] = muted ? 1.0 : 0.0;
+            storeParam(laneMuteParamId(b), muted ? 1.0 : 0.0);
         }
         return;
     }
 
     if (pid == kParamGlobalSolo) {
-        paramState_[pid] = value;
+        storeParam(pid, value);
         if (value <= 0.5) {
+            if (std::find(laneSolo_.begin(), laneSolo_.end(), true) != laneSolo_.end()) engineChanged();
             for (int b = 0; b < kMaxBeats; ++b) {
                 laneSolo_[static_cast<size_t>(b)] = false;
                 engine_.setLaneSolo(b, false);
-                paramState_[laneSoloParamId(b)] = 0.0;
+                storeParam(laneSoloParamId(b), 0.0);
             }
         }
         return;
     }
 
     if (pid == ParamIDs::kParamReset) {
-        if (value > 0.5) resetToDefaults();
+        if (value > 0.5) {
+            // Also moves the playhead back to tick 0.
+            engineChanged();
+            resetToDefaults();
+        }
         return;
     }
 
@@ -121,9 +214,10 @@ void BeatProcessor::applyNormalizedParam(ParamID pid, ParamValue value) {
         int beatIndex = static_cast<int>(pid - kLaneMuteBase);
         if (beatIndex >= 0 && beatIndex < kMaxBeats) {
             const bool muted = value > 0.5;
+            if (laneMute_[static_cast<size_t>(beatIndex)] != muted) engineChanged();
             laneMute_[static_cast<size_t>(beatIndex)] = muted;
             engine_.setLaneMute(beatIndex, muted);
-            paramState_[pid] = muted ? 1.0 : 0.0;
+            storeParam(pid, muted ? 1.0 : 0.0);
         }
         return;
     }
@@ -132,18 +226,29 @@ void BeatProcessor::applyNormalizedParam(ParamID pid, ParamValue value) {
         int beatIndex = static_cast<int>(pid - kLaneSoloBase);
         if (beatIndex >= 0 && beatIndex < kMaxBeats) {
             const bool solo = value > 0.5;
+            if (laneSolo_[static_cast<size_t>(beatIndex)] != solo) engineChanged();
             laneSolo_[static_cast<size_t>(beatIndex)] = solo;
             engine_.setLaneSolo(beatIndex, solo);
-            paramState_[pid] = solo ? 1.0 : 0.0;
+            storeParam(pid, solo ? 1.0 : 0.0);
             bool anySolo = false;
             for (bool s : laneSolo_) {
                 if (s) { anySolo = true; break; }
             }
-            paramState_[kParamGlobalSolo] = anySolo ? 1.0 : 0.0;
+            storeParam(kParamGlobalSolo, anySolo ? 1.0 : 0.0);
         }
         return;
     }
 
+    if (pid >= kLaneGateBase && pid < kLaneGateBase + kMaxBeats) {
+        const BeatParamRange& range = kBeatParamRanges[kSlotGate];
+        const int lane = static_cast<int>(pid - kLaneGateBase);
+        const int gate = normToInt(value, range.min, range.max);
+        if (engine_.laneParam(lane, kSlotGate) != gate) engineChanged();
+        engine_.setLaneParam(lane, kSlotGate, gate);
+        storeParam(pid, value);
+        return;
+    }
+
     int beatIndex = -1;
     int slot = -1;
     if (pid >= kActiveParamBase && pid < kActiveParamBase + kPerBeatParams) {
@@ -163,138 +268,108 @@ void BeatProcessor::applyNormalizedParam(ParamID pid, ParamValue value) {
     }
     if (beatIndex < 0 || beatIndex >= kMaxBeats) return;
 
-    const char* name = nullptr;
-    int min = 0;
-    int max = 0;
-    switch (slot) {
-        case BeatParamSlot::kSlotBars: name = "Bars"; min = 1; max = kMaxLoopLength; break;
-        case BeatParamSlot::kSlotLoop: name = "Loop"; min = 1; max = kMaxLoopLength; break;
-        case BeatParamSlot::kSlotBeats: name = "Beats"; min = 0; max = kMaxLoopLength; break;
-        case BeatParamSlot::kSlotRotate: name = "Rotate"; min = 0; max = kMaxLoopLength; break;
-        case BeatParamSlot::kSlotNoteIndex: name = "NoteIndex"; min = 0; max = 11; break;
-        case BeatParamSlot::kSlotOctave: name = "Octave"; min = kMinOctave; max = kMaxOctave; break;
-        case BeatParamSlot::kSlotLoud: name = "Loud"; min = 0; max = 127; break;
-        default: break;
-    }
-    if (!name) return;
-
-    int currentSelected = engine_.selectedBeat();
-    engine_.selectBeat(beatIndex + 1);
-    engine_.setBeatParam(name, normToInt(value, min, max));
-    engine_.selectBeat(currentSelected);
-    paramState_[beatParamId(beatIndex, slot)] = value;
+    if (slot < 0 || slot >= kBeatParamSlotCount) return;
+
+    const BeatParamRange& range = kBeatParamRanges[slot];
+    const int plain = normToInt(value, range.min, range.max);
+    if (engine_.laneParam(beatIndex, static_cast<BeatParamSlot>(slot)) != plain) engineChanged();
+    engine_.setLaneParam(beatIndex, static_cast<BeatParamSlot>(slot), plain);
+    storeParam(beatParamId(beatIndex, slot), value);
 }
 
 void BeatProcessor::handleParameterChanges(ProcessData& data) {
+    paramPointCount_ = 0;
+    nextParamPoint_ = 0;
     if (!data.inputParameterChanges) return;
-    int32 count = data.inputParameterChanges->getParameterCount();
+    const int32 count = data.inputParameterChanges->getParameterCount();
     for (int32 i = 0; i < count; ++i) {
         IParamValueQueue* queue = data.inputParameterChanges->getParameterData(i);
         if (!queue) continue;
-        ParamID pid = queue->getParameterId();
-        if (pid != ParamIDs::kParamBeatSelect) continue;
-        int32 points = queue->getPointCount();
-        ParamValue value = 0;
-        int32 offset = 0;
-        queue->getPoint(points - 1, offset, value);
-        applyNormalizedParam(pid, value);
+        const ParamID pid = queue->getParameterId();
+        const int32 points = queue->getPointCount();
+        if (points <= 0) continue;
+        // A queue that does not fit is thinned to the last point of each
+        // segment of the block; with no room even for that, only its final
+        // value is kept.
+        const int32 lastSample = std::max<int32>(0, data.numSamples - 1);
+        const int32 room = kMaxParamPoints - paramPointCount_;
+        int32 first = 0;
+        int32 segmentSamples = 0;
+        if (points > room) {
+            if (room >= kParamSegments) {
+                segmentSamples = std::max<int32>(1, (data.numSamples + kParamSegments - 1) / kParamSegments);
+            } else {
+                first = points - 1;
+            }
+        }
+        for (int32 p = first; p < points; ++p) {
+            ParamValue value = 0;
+            int32 offset = 0;
+            if (queue->getPoint(p, offset, value) != kResultOk) continue;
+            offset = std::clamp<int32>(offset, 0, lastSample);
+            if (segmentSamples > 0 && p + 1 < points) {
+                ParamValue nextValue = 0;
+                int32 nextOffset = 0;
+                if (queue->getPoint(p + 1, nextOffset, nextValue) == kResultOk &&
+                    std::clamp<int32>(nextOffset, 0, lastSample) / segmentSamples == offset / segmentSamples) {
+                    continue;
+                }
+            }
+            if (paramPointCount_ >= kMaxParamPoints) {
+                applyNormalizedParam(pid, value);
+                continue;
+            }
+            auto& point = paramPoints_[static_cast<size_t>(paramPointCount_)];
+            point.offset = offset;
+            point.order = paramPointCount_;
+            point.pid = pid;
+            point.value = value;
+            ++paramPointCount_;
+        }
     }
-    for (int32 i = 0; i < count; ++i) {
-        IParamValueQueue* queue = data.inputParameterChanges->getParameterData(i);
-        if (!queue) continue;
-        ParamID pid = queue->getParameterId();
-        if (pid == ParamIDs::kParamBeatSelect) continue;
-        int32 points = queue->getPointCount();
-        ParamValue value = 0;
-        int32 offset = 0;
-        queue->getPoint(points - 1, offset, value);
-        applyNormalizedParam(pid, value);
+    if (paramPointCount_ > 1) {
+        // Beat select goes first at any offset so lane-relative params see the new lane.
+        std::sort(paramPoints_.begin(), paramPoints_.begin() + paramPointCount_, [](const ParamPoint& a, const ParamPoint& b) {
+            if (a.offset != b.offset) return a.offset < b.offset;
+            const bool aSelect = a.pid == ParamIDs::kParamBeatSelect;
+            const bool bSelect = b.pid == ParamIDs::kParamBeatSelect;
+            if (aSelect != bSelect) return aSelect;
+            return a.order < b.order;
+        });
     }
 }
 
-ParamValue BeatProcessor::defaultNormalized(ParamID pid) const {
-    if (pid == ParamIDs::kParamEffectEnabled) return 0.0;
-    if (pid == kParamGlobalSolo) return 0.0;
-    if (pid == ParamIDs::kParamBeatSelect) return 0.0;
-    if (pid < kParamBaseBeatParams) return 0.0;
-
-    if (pid >= kActiveParamBase && pid < kLaneMuteBase) {
-        int slot = static_cast<int>(pid - kActiveParamBase);
-        switch (slot) {
-            case ActiveParamSlot::kActiveBars: return (4.0 - 1.0) / (kMaxLoopLength - 1.0);
-            case ActiveParamSlot::kActiveLoop: return (16.0 - 1.0) / (kMaxLoopLength - 1.0);
-            case ActiveParamSlot::kActiveBeats: return 4.0 / kMaxLoopLength;
-            case ActiveParamSlot::kActiveRotate: return 0.0;
-            case ActiveParamSlot::kActiveNoteIndex: return 0.0;
-            case ActiveParamSlot::kActiveOctave: return (2.0 - kMinOctave) / (kMaxOctave - kMinOctave);
-            case ActiveParamSlot::kActiveLoud: return 0.0;
-            default: break;
-        }
-        return 0.0;
+void BeatProcessor::applyParamPointsThrough(int32 sampleOffset) {
+    while (nextParamPoint_ < paramPointCount_ &&
+           paramPoints_[static_cast<size_t>(nextParamPoint_)].offset <= sampleOffset) {
+        const auto& point = paramPoints_[static_cast<size_t>(nextParamPoint_)];
+        applyNormalizedParam(point.pid, point.value);
+        ++nextParamPoint_;
     }
-
-    if (pid >= kLaneMuteBase && pid < kLaneSoloBase) return 0.0;
-    if (pid >= kLaneSoloBase && pid < kLaneActivityBase) return 0.0;
-    if (pid >= kLaneActivityBase) return 0.0;
-
-    int rel = static_cast<int>(pid - kParamBaseBeatParams);
-    int beatIndex = rel / kPerBeatParams;
-    int slot = rel % kPerBeatParams;
-
-    switch (slot) {
-        case BeatParamSlot::kSlotBars: return (4.0 - 1.0) / (kMaxLoopLength - 1.0);
-        case BeatParamSlot::kSlotLoop: return (16.0 - 1.0) / (kMaxLoopLength - 1.0);
-        case BeatParamSlot::kSlotBeats: return 4.0 / kMaxLoopLength;
-        case BeatParamSlot::kSlotRotate: return 0.0;
-        case BeatParamSlot::kSlotNoteIndex: return static_cast<ParamValue>(beatIndex % 12) / 11.0;
-        case BeatParamSlot::kSlotOctave: return (2.0 - kMinOctave) / (kMaxOctave - kMinOctave);
-        case BeatParamSlot::kSlotLoud: return 0.0;
-        default: break;
-    }
-    return 0.0;
 }
 
 void BeatProcessor::resetToDefaults() {
-    for (auto pid : paramOrder_) {
-        applyNormalizedParam(pid, defaultNormalized(pid));
+    for (size_t i = 0; i < kStateParamIds.size(); ++i) {
+        applyNormalizedParam(kStateParamIds[i], kStateDefaults[i]);
     }
     sampleRemainder_ = 0.0;
     globalTick_ = 0;
-    activityCountdown_.fill(0);
-    lastActivityValue_.fill(0.0);
-}
-
-void BeatProcessor::syncEngineFromParams() {
-    // No-op: we apply all params directly in applyNormalizedParam.
-}
-
-void BeatProcessor::buildParamOrder() {
-    paramOrder_.clear();
-    paramOrder_.push_back(ParamIDs::kParamEffectEnabled);
-    paramOrder_.push_back(ParamIDs::kParamBeatSelect);
-    for (int b = 0; b < kMaxBeats; ++b) {
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotBars));
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotLoop));
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotBeats));
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotRotate));
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotNoteIndex));
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotOctave));
-        paramOrder_.push_back(beatParamId(b, BeatParamSlot::kSlotLoud));
-        paramOrder_.push_back(laneMuteParamId(b));
-        paramOrder_.push_back(laneSoloParamId(b));
-    }
-    paramOrder_.push_back(kParamGlobalSolo);
-
-    // Seed defaults so save/restore matches initial behavior.
-    paramState_.clear();
-    for (auto pid : paramOrder_) {
-        paramState_[pid] = defaultNormalized(pid);
-    }
+    activityOffTick_.fill(0);
+    litLanes_ = 0;
+    blockHits_ = 0;
 }
 
 tresult PLUGIN_API BeatProcessor::process(ProcessData& data) {
+    applyPendingState();
     handleParameterChanges(data);
 
+    IEventList* outEvents = data.outputEvents;
+    const bool playing = data.processContext && (data.processContext->state & ProcessContext::kPlaying);
+    if (!playing || !outEvents || data.numSamples <= 0) {
+        // No ticks to interleave with, so every queued change lands at the start of the block.
+        applyParamPointsThrough(std::numeric_limits<int32>::max());
+    }
+
     // Keep audio silent.
     if (data.numOutputs > 0 && data.outputs) {
         for (int32 bus = 0; bus < data.numOutputs; ++bus) {
@@ -314,80 +389,41 @@ tresult PLUGIN_API BeatProcessor::process(ProcessData& data) {
 
     if (!data.processContext || !(data.processContext->state & ProcessContext::kTempoValid)) {
         // Fallback to default tempo if host does not provide it.
-        samplesPerTick_ = (sampleRate_ * 60.0) / (120.0 * 24.0);
+        samplesPerTick_ = (sampleRate_ * 60.0) / (120.0 * kTicksPerQuarter);
     } else {
         const double tempo = data.processContext->tempo > 0.0 ? data.processContext->tempo : 120.0;
-        samplesPerTick_ = (sampleRate_ * 60.0) / (tempo * 24.0);
+        samplesPerTick_ = (sampleRate_ * 60.0) / (tempo * kTicksPerQuarter);
     }
 
     if (data.numSamples <= 0) {
         return kResultOk;
     }
 
-    IEventList* outEvents = data.outputEvents;
     if (!outEvents) return kResultOk;
 
-    const bool playing = data.processContext && (data.processContext->state & ProcessContext::kPlaying);
     if (!playing) {
-        if (wasPlaying_) {
-            std::vector<BeatEvent> purgeEvents;
-            engine_.purgeAll(purgeEvents);
-            for (const auto& ev : purgeEvents) {
-                Event e{};
-                e.sampleOffset = 0;
-                e.type = Event::kNoteOffEvent;
-                e.noteOff.channel = 0;
-                e.noteOff.pitch = ev.note;
-                e.noteOff.velocity = 0.0f;
-                outEvents->addEvent(e);
-            }
-        }
+        if (wasPlaying_) releaseAll(*outEvents);
         wasPlaying_ = false;
+        clockAnchored_ = false;
         sampleRemainder_ = 0.0;
-        startDelaySamples_ = 0.0;
         globalTick_ = -1;
-        int currentSelected = engine_.selectedBeat();
-        for (int b = 0; b < kMaxBeats; ++b) {
-            engine_.selectBeat(b + 1);
-            BeatParams p = engine_.getBeatParams(b);
-            engine_.setBeatParam("Bars", p.bars);
-            engine_.setBeatParam("Loop", p.loop);
-            engine_.setBeatParam("Beats", p.beats);
-            engine_.setBeatParam("Rotate", p.rotate);
-            engine_.setBeatParam("Octave", p.octave);
-            engine_.setBeatParam("NoteIndex", p.noteIndex);
-            engine_.setBeatParam("Loud", p.loud);
-        }
-        engine_.selectBeat(currentSelected);
         return kResultOk;
     }
+    // Changes at the block's first sample come before any seek, so the engine
+    // locates with the pattern the block starts with.
+    applyParamPointsThrough(0);
+    const ProcessContext* context = data.processContext;
+    const bool hasPosition = context && (context->state & ProcessContext::kProjectTimeMusicValid);
+    double nextTickAt = samplesPerTick_ - sampleRemainder_;
     if (!wasPlaying_) {
-        startDelaySamples_ = 0.0;
-        if (data.processContext &&
-            (data.processContext->state & ProcessContext::kProjectTimeMusicValid)) {
-            double ppq = data.processContext->projectTimeMusic;
-            if (data.processContext->state & ProcessContext::kTimeSigValid) {
-                const int32 num = data.processContext->timeSigNumerator > 0 ? data.processContext->timeSigNumerator : 4;
-                const int32 den = data.processContext->timeSigDenominator > 0 ? data.processContext->timeSigDenominator : 4;
-                const double barLengthQ = num * (4.0 / static_cast<double>(den));
-                const double nearestBar = std::round(ppq / barLengthQ) * barLengthQ;
-                const double snapThresholdQ = 1.0 / 96.0;
-                if (std::abs(ppq - nearestBar) < snapThresholdQ) {
-                    ppq = nearestBar;
-                }
-            }
-            const double tickPos = ppq * 24.0;
-            const double tickFloor = std::floor(tickPos);
-            globalTick_ = static_cast<int64>(tickFloor) - 1;
-            const double tickFrac = tickPos - tickFloor;
-            if (tickFrac < 1e-4 || ppq < 1e-4) {
-                // Snap to the bar start: fire the first tick at sample offset 0.
-                sampleRemainder_ = samplesPerTick_;
-            } else {
-                sampleRemainder_ = tickFrac * samplesPerTick_;
-            }
+        if (hasPosition) {
+            locate(*context, nextTickAt);
         } else {
-            sampleRemainder_ = 0.0;
+            // No song position: run from tick 0, one tick in.
+            engineChanged();
+            nextTickAt = samplesPerTick_;
+            globalTick_ = -1;
+            engine_.seek(0);
         }
 
 #ifdef BEAT_DEBUG_NAME
@@ -409,98 +445,265 @@ tresult PLUGIN_API BeatProcessor::process(ProcessData& data) {
                 << " tempo=" << tempoLog
                 << " sig=" << numLog << "/" << denLog
                 << " samplesPerTick=" << samplesPerTick_
-                << " sampleRemainder=" << sampleRemainder_
+                << " nextTickAt=" << nextTickAt
                 << std::endl;
         }
 #endif
-        globalTick_ = -1;
-        engine_.resetTiming();
+    } else if (anchorClock(context, nextTickAt)) {
+        // Loop wrap, scrub or locate while playing: end what is sounding and
+        // carry on from the new position.
+        releaseAll(*outEvents);
+        locate(*context, nextTickAt);
     }
     wasPlaying_ = true;
 
-    double samplesToProcess = static_cast<double>(data.numSamples);
-    double cursor = 0.0;
-    if (startDelaySamples_ > 0.0) {
-        if (startDelaySamples_ >= samplesToProcess) {
-            startDelaySamples_ -= samplesToProcess;
-            return kResultOk;
+    // Split the block at parameter points so each change lands at its own sample
+    // position relative to the ticks around it.
+    const double samplesToProcess = static_cast<double>(data.numSamples);
+    while (nextParamPoint_ < paramPointCount_) {
+        const int32 offset = paramPoints_[static_cast<size_t>(nextParamPoint_)].offset;
+        renderTicks(nextTickAt, static_cast<double>(offset), false, data);
+        applyParamPointsThrough(offset);
+    }
+    renderTicks(nextTickAt, samplesToProcess, true, data);
+    publishActivity();
+    feedLookahead();
+
+    sampleRemainder_ = samplesPerTick_ - (nextTickAt - samplesToProcess);
+    return kResultOk;
+}
+
+// Places the next tick from the host's musical position rather than from the
+// previous block's remainder, so rounding and tempo changes inside earlier
+// blocks never add up. Engine tick 0 is pinned to a host tick position when the
+// host first reports one. Returns true when the position jumped (it runs
+// backwards or disagrees by more than kMaxClockCorrectionTicks) and the caller
+// has to locate; a position that stands still keeps the running phase.
+bool BeatProcessor::anchorClock(const ProcessContext* context, double& nextTickAt) {
+    if (!context || !(context->state & ProcessContext::kProjectTimeMusicValid)) {
+        clockAnchored_ = false;
+        return false;
+    }
+    const double hostTick = context->projectTimeMusic * kTicksPerQuarter;
+    const double lastHostTick = lastHostTick_;
+    lastHostTick_ = hostTick;
+    const double nextTick = static_cast<double>(globalTick_ + 1);
+    if (clockAnchored_ && hostTick != lastHostTick) {
+        const double anchoredAt = (anchorTick_ + nextTick - hostTick) * samplesPerTick_;
+        if (hostTick < lastHostTick || std::abs(anchoredAt - nextTickAt) > kMaxClockCorrectionTicks * samplesPerTick_) {
+            return true;
         }
-        cursor = startDelaySamples_;
-        startDelaySamples_ = 0.0;
-        sampleRemainder_ = 0.0;
+        nextTickAt = anchoredAt;
+        return false;
     }
-    double samplesUntilTick = samplesPerTick_ - sampleRemainder_;
+    anchorTick_ = hostTick + nextTickAt / samplesPerTick_ - nextTick;
+    clockAnchored_ = true;
+    return false;
+}
 
-    while (cursor + samplesUntilTick <= samplesToProcess) {
-        int32 sampleOffset = static_cast<int32>(std::min(cursor + samplesUntilTick, samplesToProcess - 1));
-        cursor += samplesUntilTick;
-        sampleRemainder_ = 0.0;
-        globalTick_ += 1;
-
-        std::vector<BeatEvent> events;
-        engine_.processTick(static_cast<int>(globalTick_), events);
-        for (const auto& ev : events) {
-            Event e{};
-            e.sampleOffset = sampleOffset;
-            if (ev.noteOn) {
-                e.type = Event::kNoteOnEvent;
-                e.noteOn.channel = 0;
-                e.noteOn.pitch = ev.note;
-                e.noteOn.velocity = ev.velocity / 127.f;
-                e.noteOn.length = 0;
-                if (ev.beatIndex >= 0 && ev.beatIndex < kMaxBeats) {
-                    activityCountdown_[static_cast<size_t>(ev.beatIndex)] = 2;
-                }
-            } else {
-                e.type = Event::kNoteOffEvent;
-                e.noteOff.channel = 0;
-                e.noteOff.pitch = ev.note;
-                e.noteOff.velocity = 0.0f;
-            }
-            outEvents->addEvent(e);
+// Moves the engine to the host's song position: the first whole tick at or
+// after it, with every lane's step computed from that tick. A position within
+// 1/96 of a quarter of a bar line counts as the bar line.
+void BeatProcessor::locate(const ProcessContext& context, double& nextTickAt) {
+    double ppq = context.projectTimeMusic;
+    if (context.state & ProcessContext::kTimeSigValid) {
+        const int32 num = context.timeSigNumerator > 0 ? context.timeSigNumerator : 4;
+        const int32 den = context.timeSigDenominator > 0 ? context.timeSigDenominator : 4;
+        const double barLengthQ = num * (4.0 / static_cast<double>(den));
+        const double nearestBar = std::round(ppq / barLengthQ) * barLengthQ;
+        const double snapThresholdQ = 1.0 / 96.0;
+        if (std::abs(ppq - nearestBar) < snapThresholdQ) {
+            ppq = nearestBar;
         }
+    }
+    const double tickPos = ppq * kTicksPerQuarter;
+    const double tickFloor = std::floor(tickPos);
+    const double tickFrac = tickPos - tickFloor;
+    int64 firstTick = static_cast<int64>(tickFloor);
+    if (tickFrac < 1e-4 || (ppq >= 0.0 && ppq < 1e-4)) {
+        // On (or just past) a tick: fire it at sample offset 0.
+        nextTickAt = 0.0;
+    } else {
+        firstTick += 1;
+        nextTickAt = (1.0 - tickFrac) * samplesPerTick_;
+    }
+    engineChanged();
+    globalTick_ = firstTick - 1;
+    engine_.seek(static_cast<int>(std::clamp<int64>(firstTick, 0, kNoPendingEvent - 1)));
+    activityOffTick_.fill(0);
+    litLanes_ = 0;
+
+    lastHostTick_ = context.projectTimeMusic * kTicksPerQuarter;
+    anchorTick_ = lastHostTick_ + nextTickAt / samplesPerTick_ - static_cast<double>(firstTick);
+    clockAnchored_ = true;
+}
 
-        for (int i = 0; i < kMaxBeats; ++i) {
-            double activityValue = 0.0;
-            if (activityCountdown_[static_cast<size_t>(i)] > 0) {
-                activityCountdown_[static_cast<size_t>(i)] -= 1;
-                activityValue = 1.0;
-            }
-            if (activityValue != lastActivityValue_[static_cast<size_t>(i)]) {
-                addOutputParamChange(data.outputParameterChanges, laneActivityParamId(i), activityValue, sampleOffset);
-                lastActivityValue_[static_cast<size_t>(i)] = activityValue;
+// Note-offs at the start of the block for everything still sounding.
+void BeatProcessor::releaseAll(IEventList& outEvents) {
+    engineChanged();
+    tickEvents_.clear();
+    engine_.purgeAll(tickEvents_);
+    for (const auto& ev : tickEvents_) {
+        Event e{};
+        e.sampleOffset = 0;
+        e.type = Event::kNoteOffEvent;
+        e.noteOff.channel = 0;
+        e.noteOff.pitch = ev.note;
+        e.noteOff.velocity = 0.0f;
+        outEvents.addEvent(e);
+    }
+    litLanes_ = 0;
+    activity_.clear();
+}
+
+void BeatProcessor::renderTicks(double& nextTickAt, double limit, bool inclusive, ProcessData& data) {
+    const double gap = limit - nextTickAt;
+    int64 ticksInSegment = 0;
+    if (inclusive && gap >= 0.0) {
+        ticksInSegment = 1 + static_cast<int64>(std::floor(gap / samplesPerTick_));
+    } else if (!inclusive && gap > 0.0) {
+        ticksInSegment = static_cast<int64>(std::ceil(gap / samplesPerTick_));
+    }
+    if (ticksInSegment <= 0) return;
+
+    const int firstTick = static_cast<int>(globalTick_ + 1);
+    const int endTick = static_cast<int>(globalTick_ + 1 + ticksInSegment);
+
+    // The engine runs the whole segment into the sink (in chunks if it fills up),
+    // then each event's tick maps straight to its sample offset. Ticks before
+    // the song start are a silent count-in. With lookahead the worker's chunks
+    // already hold the events, which are copied out as they are.
+    for (int tick = std::max(firstTick, 0); tick < endTick;) {
+        if (lookaheadOn_ || (lookahead_.running() && !lookaheadStale_)) {
+            const BeatLookahead::Chunk* chunk = lookahead_.chunkAt(tick);
+            if (chunk && tick < chunk->endTick) {
+                lookaheadOn_ = true;
+                const int end = std::min(endTick, chunk->endTick);
+                auto byTick = [](const BeatEvent& ev, int t) { return ev.tick < t; };
+                const BeatEvent* first = std::lower_bound(chunk->events.begin(), chunk->events.end(), tick, byTick);
+                const BeatEvent* last = std::lower_bound(first, chunk->events.end(), end, byTick);
+                emitEvents(first, last, nextTickAt, firstTick, data);
+                tick = end;
+                continue;
             }
+            // The worker is behind; carry on inline until it catches up.
+            resumeEngine(tick);
         }
+        tickEvents_.clear();
+        tick = engine_.processRange(tick, endTick, tickEvents_);
+        emitEvents(tickEvents_.begin(), tickEvents_.end(), nextTickAt, firstTick, data);
+    }
 
-        samplesUntilTick = samplesPerTick_;
+    // Lights whose hold ran out within the segment.
+    for (BeatLaneMask lanes = litLanes_; lanes != 0; lanes &= lanes - 1) {
+        const int i = lowestLane(lanes);
+        if (activityOffTick_[static_cast<size_t>(i)] < endTick) litLanes_ &= ~(BeatLaneMask{1} << i);
     }
 
-    sampleRemainder_ += samplesToProcess - cursor;
-    return kResultOk;
+    globalTick_ = endTick - 1;
+    nextTickAt += static_cast<double>(ticksInSegment) * samplesPerTick_;
 }
 
-tresult PLUGIN_API BeatProcessor::setState(IBStream* state) {
-    IBStreamer streamer(state, kLittleEndian);
-    for (auto pid : paramOrder_) {
-        double v = 0.0;
-        if (!streamer.readDouble(v)) v = defaultNormalized(pid);
-        if (pid != kParamGlobalSolo) {
-            applyNormalizedParam(pid, v);
+// Sends events of the segment that starts with firstTick at sample firstTickAt.
+void BeatProcessor::emitEvents(const BeatEvent* first, const BeatEvent* last, double firstTickAt, int firstTick,
+                               ProcessData& data) {
+    const double lastSample = static_cast<double>(data.numSamples - 1);
+    for (const BeatEvent* ev = first; ev != last; ++ev) {
+        if (ev->coalesced) {
+            lightLane(ev->beatIndex, ev->tick);
+            continue;
+        }
+        Event e{};
+        e.sampleOffset = static_cast<int32>(
+            std::clamp(firstTickAt + static_cast<double>(ev->tick - firstTick) * samplesPerTick_, 0.0, lastSample));
+        if (ev->noteOn) {
+            e.type = Event::kNoteOnEvent;
+            e.noteOn.channel = 0;
+            e.noteOn.pitch = ev->note;
+            e.noteOn.velocity = ev->velocity / 127.f;
+            e.noteOn.length = 0;
+            if (ev->beatIndex >= 0 && ev->beatIndex < kMaxBeats) {
+                lightLane(ev->beatIndex, ev->tick);
+            }
+        } else {
+            e.type = Event::kNoteOffEvent;
+            e.noteOff.channel = 0;
+            e.noteOff.pitch = ev->note;
+            e.noteOff.velocity = 0.0f;
         }
+        data.outputEvents->addEvent(e);
     }
-    return kResultOk;
 }
 
-tresult PLUGIN_API BeatProcessor::getState(IBStream* state) {
-    IBStreamer streamer(state, kLittleEndian);
-    for (auto pid : paramOrder_) {
-        double v = 0.0;
-        auto it = paramState_.find(pid);
-        if (it != paramState_.end()) v = it->second;
-        streamer.writeDouble(v);
+// Next engine tick to run; the count-in waits at tick 0.
+int BeatProcessor::playheadTick() const {
+    return static_cast<int>(std::clamp<int64>(globalTick_ + 1, 0, kNoPendingEvent - 1));
+}
+
+// Takes engine_ back from the worker at tick: the chunk holding tick restarts
+// it and runs it up to tick, so the cost is at most one chunk of ticks.
+void BeatProcessor::resumeEngine(int tick) {
+    if (!lookaheadOn_) return;
+    lookaheadOn_ = false;
+    const BeatLookahead::Chunk* chunk = lookahead_.chunkAt(tick);
+    if (!chunk) return;
+    engine_ = chunk->start;
+    for (int t = chunk->firstTick; t < tick;) {
+        tickEvents_.clear();
+        t = engine_.processRange(t, tick, tickEvents_);
     }
+    tickEvents_.clear();
+}
+
+// Called before anything changes engine_: what the worker rendered no longer applies.
+void BeatProcessor::engineChanged() {
+    resumeEngine(playheadTick());
+    lookaheadStale_ = true;
+}
+
+// End of a playing block: tells the worker where playback is and, after a
+// change, hands it the engine to render from. Until its chunks reach the
+// playhead, blocks render inline.
+void BeatProcessor::feedLookahead() {
+    if (!lookahead_.running()) return;
+    const int tick = playheadTick();
+    lookahead_.setPlayhead(tick);
+    if (lookaheadStale_ && lookahead_.restart(engine_, tick)) lookaheadStale_ = false;
+}
+
+void BeatProcessor::lightLane(int lane, int64 tick) {
+    const BeatLaneMask bit = BeatLaneMask{1} << lane;
+    litLanes_ |= bit;
+    blockHits_ |= bit;
+    activityOffTick_[static_cast<size_t>(lane)] = tick + kActivityHoldTicks;
+}
+
+// Once per block: the editor reads lights from the channel, so the audio
+// thread writes no output parameters for them.
+void BeatProcessor::publishActivity() {
+    activity_.publish(litLanes_, blockHits_);
+    blockHits_ = 0;
+}
+
+tresult PLUGIN_API BeatProcessor::setState(IBStream* state) {
+    std::vector<uint8_t> bytes;
+    if (!readStateStream(state, bytes)) return kResultFalse;
+    std::array<double, kStateValueCount> values = kStateDefaults;
+    if (!decodeState(bytes.data(), bytes.size(), values.data())) return kResultFalse;
+    postState(values);
     return kResultOk;
 }
 
+tresult PLUGIN_API BeatProcessor::getState(IBStream* state) {
+    // A state posted but not yet applied by process() is the one to save. Only
+    // this thread writes pendingValues_, so it reads them as they stand.
+    const bool pending = appliedSeq_.load(std::memory_order_acquire) != pendingSeq_.load(std::memory_order_relaxed);
+    const auto& source = pending ? pendingValues_ : stateValues_;
+    std::array<ParamValue, kStateValueCount> values{};
+    for (size_t i = 0; i < values.size(); ++i) values[i] = source[i].load(std::memory_order_relaxed);
+    std::vector<uint8_t> bytes = encodeState(values.data());
+    return writeStateStream(state, bytes) ? kResultOk : kResultFalse;
+}
+
 } // namespace beatvst
 
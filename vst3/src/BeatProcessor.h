@@ -2,12 +2,17 @@
 // MIT License
 #pragma once
 
+#include "BeatActivity.h"
 #include "BeatEngine.h"
 #include "BeatIDs.h"
+#include "BeatLookahead.h"
+#include "BeatParamTable.h"
+#include "BeatState.h"
 
 #include "public.sdk/source/vst/vstaudioeffect.h"
 #include <array>
-#include <unordered_map>
+#include <atomic>
+#include <cstdint>
 
 namespace beatvst {
 
@@ -20,6 +25,8 @@ public:
     // VST3
     Steinberg::tresult PLUGIN_API initialize(Steinberg::FUnknown* context) SMTG_OVERRIDE;
     Steinberg::tresult PLUGIN_API terminate() SMTG_OVERRIDE;
+    Steinberg::tresult PLUGIN_API notify(Steinberg::Vst::IMessage* message) SMTG_OVERRIDE;
+    Steinberg::tresult PLUGIN_API setActive(Steinberg::TBool state) SMTG_OVERRIDE;
     Steinberg::tresult PLUGIN_API setState(Steinberg::IBStream* state) SMTG_OVERRIDE;
     Steinberg::tresult PLUGIN_API getState(Steinberg::IBStream* state) SMTG_OVERRIDE;
     Steinberg::tresult PLUGIN_API setBusArrangements(Steinberg::Vst::SpeakerArrangement* inputs, Steinberg::int32 numIns,
@@ -34,26 +41,85 @@ public:
 
 protected:
     void handleParameterChanges(Steinberg::Vst::ProcessData& data);
+    void applyParamPointsThrough(Steinberg::int32 sampleOffset);
+    bool anchorClock(const Steinberg::Vst::ProcessContext* context, double& nextTickAt);
+    void locate(const Steinberg::Vst::ProcessContext& context, double& nextTickAt);
+    void releaseAll(Steinberg::Vst::IEventList& outEvents);
+    void renderTicks(double& nextTickAt, double limit, bool inclusive, Steinberg::Vst::ProcessData& data);
+    void emitEvents(const BeatEvent* first, const BeatEvent* last, double firstTickAt, int firstTick,
+                    Steinberg::Vst::ProcessData& data);
+    int playheadTick() const;
+    void resumeEngine(int tick);
+    void engineChanged();
+    void feedLookahead();
+    void lightLane(int lane, Steinberg::int64 tick);
+    void publishActivity();
+    void sendActivity();
+    void receiveState(const void* data, Steinberg::uint32 size);
+    void postState(const std::array<Steinberg::Vst::ParamValue, kStateValueCount>& values);
+    void applyPendingState();
     void applyNormalizedParam(Steinberg::Vst::ParamID pid, Steinberg::Vst::ParamValue value);
-    void buildParamOrder();
-    void syncEngineFromParams();
     void resetToDefaults();
-    Steinberg::Vst::ParamValue defaultNormalized(Steinberg::Vst::ParamID pid) const;
+    // Records a value for getState; params that are not saved are ignored.
+    void storeParam(Steinberg::Vst::ParamID pid, Steinberg::Vst::ParamValue value) {
+        const int index = paramStateIndex(pid);
+        if (index >= 0) stateValues_[static_cast<size_t>(index)].store(value, std::memory_order_relaxed);
+    }
 
     BeatEngine engine_;
+    BeatEventSink tickEvents_;
     Steinberg::Vst::SampleRate sampleRate_{44100.0};
-    double samplesPerTick_{(60.0 / 120.0) / 24.0}; // default 120 bpm, 24 ppq
+    double samplesPerTick_{(60.0 / 120.0) / kTicksPerQuarter}; // default 120 bpm
     double sampleRemainder_{0.0};
-    double startDelaySamples_{0.0};
     Steinberg::int64 globalTick_{0};
+    double anchorTick_{0.0};  // host tick position (quarters * kTicksPerQuarter) of engine tick 0
+    double lastHostTick_{0.0};  // host tick position at the start of the previous block
+    bool clockAnchored_{false};  // anchorTick_ is valid for the current run
     bool wasPlaying_{false};
-    std::vector<Steinberg::Vst::ParamID> paramOrder_;
     int currentSelected_{1};
-    std::unordered_map<Steinberg::Vst::ParamID, double> paramState_;
+    // In kStateParamIds order. Atomic so getState can read them on the UI
+    // thread while the audio thread writes them.
+    std::array<std::atomic<Steinberg::Vst::ParamValue>, kStateValueCount> stateValues_;
     std::array<bool, kMaxBeats> laneMute_{};
     std::array<bool, kMaxBeats> laneSolo_{};
-    std::array<int, kMaxBeats> activityCountdown_{};
-    std::array<double, kMaxBeats> lastActivityValue_{};
+    std::array<Steinberg::int64, kMaxBeats> activityOffTick_{};  // tick at which a lit lane goes dark
+    BeatLaneMask litLanes_{0};
+    BeatLaneMask blockHits_{0};  // lanes struck in the current block
+    BeatActivityChannel activity_;
+
+    // Optional lookahead (BeatLookahead.h). While lookaheadOn_ the block's
+    // events come from the worker and engine_ stays where the worker was
+    // handed it; resumeEngine() brings it up to the playhead before anything
+    // else uses it. lookaheadStale_ marks an engine_ the worker has not seen.
+    BeatLookaheadMember lookahead_;
+    bool lookaheadOn_{false};
+    bool lookaheadStale_{true};
+
+    // State sent by the controller, handed to the audio thread whole. The UI
+    // thread writes pendingValues_ (in kStateParamIds order) between two bumps
+    // of pendingSeq_, which is odd while it writes; process() copies it before
+    // the block's own parameter changes and, if pendingSeq_ moved meanwhile,
+    // leaves it for the next block. Neither side ever waits for the other.
+    std::array<std::atomic<Steinberg::Vst::ParamValue>, kStateValueCount> pendingValues_{};
+    std::array<Steinberg::Vst::ParamValue, kStateValueCount> takenValues_{};  // audio thread
+    std::atomic<uint32_t> pendingSeq_{0};  // UI thread writes
+    std::atomic<uint32_t> appliedSeq_{0};  // last pendingSeq_ applied
+    bool active_{false};  // UI thread only
+
+    // Parameter points of the current block, sorted by sample offset.
+    struct ParamPoint {
+        Steinberg::int32 offset{0};
+        Steinberg::int32 order{0};
+        Steinberg::Vst::ParamID pid{0};
+        Steinberg::Vst::ParamValue value{0.0};
+    };
+    static constexpr Steinberg::int32 kMaxParamPoints = 128;
+    // A queue that does not fit keeps only its last point in each of this many
+    // equal parts of the block.
+    static constexpr Steinberg::int32 kParamSegments = 16;
+    std::array<ParamPoint, kMaxParamPoints> paramPoints_{};
+    Steinberg::int32 paramPointCount_{0};
+    Steinberg::int32 nextParamPoint_{0};
 };
 
 } // namespace beatvst
@@ -0,0 +1,157 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+#include "BeatState.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace beatvst {
+
+namespace {
+
+constexpr size_t kHeaderSize = 8;    // magic, version, lane count
+constexpr size_t kChecksumSize = 4;
+constexpr int kLegacyLanes = 8;      // the original format predates other lane counts
+
+struct StateField {
+    int index;  // position in this build's layout, -1 when it has no such value
+    BeatParamRange range;
+    size_t width;  // bytes in the compact format
+};
+
+// Field savedIndex of the layout for a build with the given lane count.
+StateField stateField(int savedIndex, int lanes) {
+    constexpr BeatParamRange kSwitch{0, 1};
+    auto field = [](int index, BeatParamRange range) {
+        return StateField{index, range, range.max - range.min > 0xFF ? size_t{2} : size_t{1}};
+    };
+    if (savedIndex == kStateMuteAll) return field(kStateMuteAll, kSwitch);
+    if (savedIndex == kStateBeatSelect) return field(kStateBeatSelect, {1, lanes});
+    const int globalSolo = 2 + lanes * kStateLaneStride;
+    if (savedIndex < globalSolo) {
+        const int lane = (savedIndex - 2) / kStateLaneStride;
+        const int slot = (savedIndex - 2) % kStateLaneStride;
+        return field(lane < kMaxBeats ? stateLaneIndex(lane, slot) : -1, slot < kSlotGate ? kBeatParamRanges[slot] : kSwitch);
+    }
+    if (savedIndex == globalSolo) return field(kStateGlobalSolo, kSwitch);
+    const int lane = savedIndex - globalSolo - 1;
+    return field(lane < kMaxBeats ? stateGateIndex(lane) : -1, kBeatParamRanges[kSlotGate]);
+}
+
+struct StateLayout {
+    std::vector<StateField> fields;
+    size_t payloadSize{0};
+};
+
+StateLayout buildLayout(int lanes) {
+    StateLayout layout;
+    const int count = 2 + lanes * kStateLaneStride + 1 + lanes;
+    layout.fields.reserve(static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        layout.fields.push_back(stateField(i, lanes));
+        layout.payloadSize += layout.fields.back().width;
+    }
+    return layout;
+}
+
+// Layout of this build, worked out once.
+const StateLayout& currentLayout() {
+    static const StateLayout layout = buildLayout(kMaxBeats);
+    return layout;
+}
+
+// Normalized value of plain within range.
+double normalizedIn(int plain, BeatParamRange range) {
+    const int span = range.max - range.min;
+    return span > 0 ? static_cast<double>(std::clamp(plain, range.min, range.max) - range.min) / span : 0.0;
+}
+
+uint32_t fnv1a(const uint8_t* data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void putLE(std::vector<uint8_t>& out, uint32_t value, size_t bytes) {
+    for (size_t b = 0; b < bytes; ++b) out.push_back(static_cast<uint8_t>(value >> (8 * b)));
+}
+
+uint32_t getLE(const uint8_t* data, size_t bytes) {
+    uint32_t value = 0;
+    for (size_t b = 0; b < bytes; ++b) value |= static_cast<uint32_t>(data[b]) << (8 * b);
+    return value;
+}
+
+} // namespace
+
+std::vector<uint8_t> encodeState(const double* values) {
+    const StateLayout& layout = currentLayout();
+    std::vector<uint8_t> out;
+    out.reserve(kHeaderSize + layout.payloadSize + kChecksumSize);
+    putLE(out, kStateMagic, 4);
+    putLE(out, kStateVersion, 2);
+    putLE(out, static_cast<uint32_t>(kMaxBeats), 2);
+    for (size_t i = 0; i < layout.fields.size(); ++i) {
+        const StateField& field = layout.fields[i];
+        const int span = field.range.max - field.range.min;
+        const double norm = std::clamp(values[i], 0.0, 1.0);
+        putLE(out, static_cast<uint32_t>(std::lround(norm * span)), field.width);
+    }
+    putLE(out, fnv1a(out.data(), out.size()), kChecksumSize);
+    return out;
+}
+
+bool decodeState(const uint8_t* data, size_t size, double* values) {
+    if (size < 4 || getLE(data, 4) != kStateMagic) {
+        // Original format: one little-endian double per value of the 8-lane
+        // layout, no header. Mapped like a current state from another lane count.
+        static const StateLayout legacy = buildLayout(kLegacyLanes);
+        const StateLayout& current = currentLayout();
+        const size_t count = std::min(size / 8, legacy.fields.size());
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t bits = 0;
+            for (size_t b = 0; b < 8; ++b) bits |= static_cast<uint64_t>(data[i * 8 + b]) << (8 * b);
+            double value = 0.0;
+            std::memcpy(&value, &bits, sizeof(double));
+            const StateField& field = legacy.fields[i];
+            if (field.index < 0) continue;
+            const BeatParamRange range = current.fields[static_cast<size_t>(field.index)].range;
+            if (range.min == field.range.min && range.max == field.range.max) {
+                values[field.index] = value;
+                continue;
+            }
+            const int plain = field.range.min + static_cast<int>(std::lround(std::clamp(value, 0.0, 1.0) * (field.range.max - field.range.min)));
+            values[field.index] = normalizedIn(plain, range);
+        }
+        return true;
+    }
+
+    if (size < kHeaderSize + kChecksumSize) return false;
+    const uint32_t version = getLE(data + 4, 2);
+    const int lanes = static_cast<int>(getLE(data + 6, 2));
+    if (version != kStateVersion || lanes < 1 || lanes > 64) return false;
+    // A state from a build with another lane count maps through its own layout.
+    StateLayout foreign;
+    if (lanes != kMaxBeats) foreign = buildLayout(lanes);
+    const StateLayout& saved = lanes == kMaxBeats ? currentLayout() : foreign;
+    const size_t body = size - kChecksumSize;
+    if (body != kHeaderSize + saved.payloadSize) return false;
+    if (getLE(data + body, kChecksumSize) != fnv1a(data, body)) return false;
+
+    const StateLayout& current = currentLayout();
+    const uint8_t* p = data + kHeaderSize;
+    for (const StateField& field : saved.fields) {
+        const int plain = field.range.min + static_cast<int>(getLE(p, field.width));
+        p += field.width;
+        if (field.index < 0) continue;
+        // Only Beat Select's range differs between lane counts.
+        values[field.index] = normalizedIn(plain, current.fields[static_cast<size_t>(field.index)].range);
+    }
+    return true;
+}
+
+} // namespace beatvst
@@ -0,0 +1,44 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+#pragma once
+
+#include "BeatEngine.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace beatvst {
+
+// Saved plugin state. Values are normalized parameter values in this order:
+// Mute All, Beat Select, per lane Bars..Loud then Mute and Solo, Global Solo,
+// then every lane's Gate. BeatParamTable.h maps each one to its parameter.
+constexpr int kStateMuteAll = 0;
+constexpr int kStateBeatSelect = 1;
+constexpr int kStateLaneMute = kSlotGate;  // lane block field after Bars..Loud
+constexpr int kStateLaneSolo = kSlotGate + 1;
+constexpr int kStateLaneStride = kSlotGate + 2;
+constexpr int kStateGlobalSolo = 2 + kMaxBeats * kStateLaneStride;
+constexpr int kStateValueCount = kStateGlobalSolo + 1 + kMaxBeats;
+
+constexpr int stateLaneIndex(int lane, int field) { return 2 + lane * kStateLaneStride + field; }
+constexpr int stateGateIndex(int lane) { return kStateGlobalSolo + 1 + lane; }
+
+// Current format: "BEAT", version and lane count, then each value as its plain
+// integer offset from the range minimum in one byte (two when the range needs
+// it), then an FNV-1a checksum of everything before it. All little-endian.
+constexpr uint32_t kStateMagic = 0x54414542;  // "BEAT"
+constexpr uint16_t kStateVersion = 1;
+
+// Encodes kStateValueCount normalized values.
+std::vector<uint8_t> encodeState(const double* values);
+
+// Decodes the current format, or the original headerless stream of
+// little-endian doubles (always the 8-lane layout), into kStateValueCount
+// normalized values. States from a
+// build with another lane count load the lanes both have. Values the state does
+// not contain are left as they were. Returns false, changing nothing, for a
+// current-format state that is damaged or from a newer version.
+bool decodeState(const uint8_t* data, size_t size, double* values);
+
+} // namespace beatvst
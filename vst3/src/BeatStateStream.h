@@ -0,0 +1,39 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+#pragma once
+
+#include "pluginterfaces/base/ibstream.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace beatvst {
+
+// Saved states are small; anything larger is not ours.
+constexpr Steinberg::int32 kMaxStateBytes = 1 << 20;
+
+// Reads the rest of the stream in a few large reads so the state can be decoded
+// from memory in one pass (see BeatState.h).
+inline bool readStateStream(Steinberg::IBStream* stream, std::vector<uint8_t>& bytes) {
+    if (!stream) return false;
+    constexpr Steinberg::int32 kChunk = 4096;
+    bytes.clear();
+    for (;;) {
+        const size_t used = bytes.size();
+        if (used >= static_cast<size_t>(kMaxStateBytes)) return false;
+        bytes.resize(used + kChunk);
+        Steinberg::int32 read = 0;
+        const Steinberg::tresult result = stream->read(bytes.data() + used, kChunk, &read);
+        bytes.resize(used + static_cast<size_t>(read > 0 ? read : 0));
+        if (result != Steinberg::kResultOk || read <= 0) return true;
+    }
+}
+
+inline bool writeStateStream(Steinberg::IBStream* stream, std::vector<uint8_t>& bytes) {
+    if (!stream) return false;
+    Steinberg::int32 written = 0;
+    const auto size = static_cast<Steinberg::int32>(bytes.size());
+    return stream->write(bytes.data(), size, &written) == Steinberg::kResultOk && written == size;
+}
+
+} // namespace beatvst
@@ -0,0 +1,737 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+//
+// beat_engine unit tests. Plain checks with no framework: each failure prints
+// its location and the run exits non-zero.
+//
+//   beat_engine_tests
+#include "BeatEngine.h"
+#include "BeatState.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <new>
+#include <random>
+#include <vector>
+
+using namespace beatvst;
+
+// Every heap allocation in the process goes through here, so a test can count
+// the ones made while it runs the audio-thread path.
+namespace {
+long allocationCount = 0;
+}
+
+void* operator new(std::size_t size) {
+    ++allocationCount;
+    if (void* p = std::malloc(size != 0 ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            ++failures;                                                             \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                                           \
+    } while (0)
+
+bool sameEvent(const BeatEvent& a, const BeatEvent& b) {
+    return a.beatIndex == b.beatIndex && a.note == b.note && a.velocity == b.velocity && a.noteOn == b.noteOn &&
+           a.tick == b.tick && a.coalesced == b.coalesced;
+}
+
+bool sameEvents(const std::vector<BeatEvent>& a, const std::vector<BeatEvent>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), sameEvent);
+}
+
+void setLane(BeatEngine& engine, int lane, const BeatParams& p) {
+    engine.setLaneParam(lane, kSlotBars, p.bars);
+    engine.setLaneParam(lane, kSlotLoop, p.loop);
+    engine.setLaneParam(lane, kSlotBeats, p.beats);
+    engine.setLaneParam(lane, kSlotRotate, p.rotate);
+    engine.setLaneParam(lane, kSlotNoteIndex, p.noteIndex);
+    engine.setLaneParam(lane, kSlotOctave, p.octave);
+    engine.setLaneParam(lane, kSlotLoud, p.loud);
+    engine.setLaneParam(lane, kSlotGate, p.gate);
+}
+
+// Random lanes on a few pitches, so lanes share notes and gates overlap hits.
+BeatParams randomLane(std::mt19937& rng) {
+    BeatParams p;
+    p.bars = 1 + static_cast<int>(rng() % 2);
+    p.loop = 1 + static_cast<int>(rng() % 16);
+    p.beats = static_cast<int>(rng() % (p.loop + 1));
+    p.rotate = static_cast<int>(rng() % (p.loop + 1));
+    p.noteIndex = static_cast<int>(rng() % 3);
+    p.octave = 2;
+    p.loud = 1 + static_cast<int>(rng() % 127);
+    p.gate = 1 + static_cast<int>(rng() % 96);
+    return p;
+}
+
+BeatEngine randomEngine(std::mt19937& rng) {
+    BeatEngine engine;
+    for (int lane = 0; lane < kMaxBeats; ++lane) setLane(engine, lane, randomLane(rng));
+    engine.seek(0);
+    return engine;
+}
+
+// Runs ticks [firstTick, endTick) one processTick() at a time.
+void runTicks(BeatEngine& engine, int firstTick, int endTick, std::vector<BeatEvent>& out) {
+    BeatEventSink sink;
+    for (int tick = firstTick; tick < endTick; ++tick) {
+        sink.clear();
+        engine.processTick(tick, sink);
+        out.insert(out.end(), sink.begin(), sink.end());
+    }
+}
+
+// Runs ticks [firstTick, endTick) the way process() does: processTick() only on
+// event ticks, skipTicks() over the silent ones in between.
+void runSkipping(BeatEngine& engine, int firstTick, int endTick, std::vector<BeatEvent>& out) {
+    BeatEventSink sink;
+    for (int tick = firstTick; tick < endTick;) {
+        sink.clear();
+        engine.processTick(tick, sink);
+        out.insert(out.end(), sink.begin(), sink.end());
+        ++tick;
+        const int silent = std::min(engine.ticksUntilNextEvent(tick) - 1, endTick - tick);
+        if (silent > 0) {
+            engine.skipTicks(silent);
+            tick += silent;
+        }
+    }
+}
+
+// Runs ticks [firstTick, endTick) through processRange() in random spans.
+void runRange(BeatEngine& engine, int firstTick, int endTick, std::mt19937& rng, std::vector<BeatEvent>& out) {
+    BeatEventSink sink;
+    for (int tick = firstTick; tick < endTick;) {
+        const int spanEnd = std::min(endTick, tick + 1 + static_cast<int>(rng() % 200));
+        while (tick < spanEnd) {
+            sink.clear();
+            tick = engine.processRange(tick, spanEnd, sink);
+            out.insert(out.end(), sink.begin(), sink.end());
+        }
+    }
+}
+
+// Every note-on sent as MIDI has exactly one note-off, and no pitch is ended
+// while it is not sounding.
+bool balanced(const std::vector<BeatEvent>& events) {
+    std::array<int, 128> sounding{};
+    for (const BeatEvent& ev : events) {
+        if (ev.coalesced) continue;
+        int& n = sounding[ev.note & 0x7F];
+        if (ev.noteOn) {
+            if (n != 0) return false;
+            n = 1;
+        } else {
+            if (n != 1) return false;
+            n = 0;
+        }
+    }
+    return std::all_of(sounding.begin(), sounding.end(), [](int n) { return n == 0; });
+}
+
+void testProcessRangeMatchesTicks() {
+    std::mt19937 rng(1);
+    for (int round = 0; round < 200; ++round) {
+        BeatEngine byTick = randomEngine(rng);
+        BeatEngine byRange = byTick;
+        std::vector<BeatEvent> a;
+        std::vector<BeatEvent> b;
+        // A parameter change part way through lands on the same tick in both.
+        const int changeAt = 1 + static_cast<int>(rng() % 2000);
+        const int lane = static_cast<int>(rng() % kMaxBeats);
+        const BeatParams change = randomLane(rng);
+        runTicks(byTick, 0, changeAt, a);
+        runRange(byRange, 0, changeAt, rng, b);
+        setLane(byTick, lane, change);
+        setLane(byRange, lane, change);
+        runTicks(byTick, changeAt, 4000, a);
+        runRange(byRange, changeAt, 4000, rng, b);
+        CHECK(sameEvents(a, b));
+    }
+}
+
+void testSkipMatchesTicks() {
+    std::mt19937 rng(5);
+    for (int round = 0; round < 200; ++round) {
+        BeatEngine byTick = randomEngine(rng);
+        BeatEngine skipping = byTick;
+        std::vector<BeatEvent> a;
+        std::vector<BeatEvent> b;
+        // A parameter change part way through lands on the same tick in both.
+        const int changeAt = 1 + static_cast<int>(rng() % 2000);
+        const int lane = static_cast<int>(rng() % kMaxBeats);
+        const BeatParams change = randomLane(rng);
+        runTicks(byTick, 0, changeAt, a);
+        runSkipping(skipping, 0, changeAt, b);
+        setLane(byTick, lane, change);
+        setLane(skipping, lane, change);
+        runTicks(byTick, changeAt, 4000, a);
+        runSkipping(skipping, changeAt, 4000, b);
+        CHECK(sameEvents(a, b));
+    }
+}
+
+void testEventsInRangeMatchesProcessRange() {
+    std::mt19937 rng(7);
+    for (int round = 0; round < 200; ++round) {
+        BeatEngine engine = randomEngine(rng);
+        for (int lane = 0; lane < kMaxBeats; ++lane) {
+            if (rng() % 6 == 0) engine.setLaneMute(lane, true);
+            if (rng() % 8 == 0) engine.setLaneSolo(lane, true);
+        }
+        // Windows from tick 0, inside a note and on hit ticks alike.
+        const int firstTick = round % 4 == 0 ? 0 : static_cast<int>(rng() % 3000);
+        const int endTick = firstTick + static_cast<int>(rng() % 1000);
+        std::vector<BeatEvent> computed;
+        engine.eventsInRange(firstTick, endTick, computed);
+
+        BeatEngine played = engine;
+        std::vector<BeatEvent> all;
+        runRange(played, 0, endTick, rng, all);
+        std::vector<BeatEvent> window;
+        std::copy_if(all.begin(), all.end(), std::back_inserter(window),
+                     [&](const BeatEvent& ev) { return ev.tick >= firstTick; });
+        CHECK(sameEvents(computed, window));
+    }
+}
+
+void testKnownPatterns() {
+    // Bit i is step i.
+    CHECK(euclideanPattern(8, 3) == 0b01001001u);    // x..x..x.
+    CHECK(euclideanPattern(8, 5) == 0b01101101u);    // x.xx.xx.
+    CHECK(euclideanPattern(5, 2) == 0b00101u);       // x.x..
+    CHECK(euclideanPattern(12, 4) == 0x249u);        // x..x..x..x..
+    CHECK(euclideanPattern(16, 4) == 0x1111u);       // x...x...x...x...
+    CHECK(euclideanPattern(4, 4) == 0xFu);
+    CHECK(euclideanPattern(7, 0) == 0u);
+    CHECK(euclideanPattern(3, 4) == 0u);             // more beats than steps
+    for (int loop = 1; loop <= kMaxLoopLength; ++loop) {
+        for (int beats = 1; beats <= loop; ++beats) {
+            const uint32_t pattern = euclideanPattern(loop, beats);
+            int hits = 0;
+            for (uint32_t m = pattern; m != 0; m &= m - 1) ++hits;
+            CHECK(hits == beats);
+            CHECK((pattern & 1u) != 0);  // the first step is a hit
+        }
+    }
+    CHECK(rotatePattern(0b0001u, 4, 1) == 0b0010u);
+    CHECK(rotatePattern(0b1000u, 4, 1) == 0b0001u);
+    CHECK(rotatePattern(0b0011u, 4, -1) == 0b1001u);
+}
+
+// The runtime Bjorklund the pattern table replaced: one int per step, rotated
+// so the first step is a hit.
+std::vector<int> referenceBjorklund(int steps, int pulses) {
+    std::vector<int> pattern;
+    if (pulses > steps) return pattern;
+    if (pulses == 0) {
+        pattern.assign(static_cast<size_t>(steps), 0);
+        return pattern;
+    }
+    std::vector<int> counts;
+    std::vector<int> remainders;
+    remainders.push_back(pulses);
+    int divisor = steps - pulses;
+    int level = 0;
+    while (true) {
+        counts.push_back(divisor / remainders[static_cast<size_t>(level)]);
+        remainders.push_back(divisor % remainders[static_cast<size_t>(level)]);
+        divisor = remainders[static_cast<size_t>(level)];
+        level++;
+        if (remainders[static_cast<size_t>(level)] < 2) break;
+    }
+    counts.push_back(divisor);
+
+    std::function<void(int)> build = [&](int l) {
+        if (l == -1) {
+            pattern.push_back(0);
+        } else if (l == -2) {
+            pattern.push_back(1);
+        } else {
+            for (int i = 0; i < counts[static_cast<size_t>(l)]; ++i) build(l - 1);
+            if (remainders[static_cast<size_t>(l)] != 0) build(l - 2);
+        }
+    };
+    build(level);
+    auto it = std::find(pattern.begin(), pattern.end(), 1);
+    if (it != pattern.end()) std::rotate(pattern.begin(), it, pattern.end());
+    return pattern;
+}
+
+// Every (loop, beats, rotate) the parameters allow, table and bit-rotate
+// against the reference and the std::rotate the lanes used to do.
+void testPatternTableMatchesReference() {
+    for (int loop = 1; loop <= kMaxLoopLength; ++loop) {
+        for (int beats = 0; beats <= kMaxLoopLength; ++beats) {
+            const std::vector<int> steps = referenceBjorklund(loop, beats);
+            for (int rotate = 0; rotate <= kMaxLoopLength; ++rotate) {
+                uint32_t expected = 0;
+                if (!steps.empty()) {
+                    std::vector<int> rotated = steps;
+                    const int r = rotate % loop;
+                    std::rotate(rotated.begin(), rotated.end() - r, rotated.end());
+                    for (int i = 0; i < loop; ++i) {
+                        if (rotated[static_cast<size_t>(i)] != 0) expected |= 1u << i;
+                    }
+                }
+                const uint32_t actual = rotatePattern(euclideanPattern(loop, beats), loop, rotate);
+                if (actual != expected) {
+                    std::fprintf(stderr, "pattern loop=%d beats=%d rotate=%d: %08x, reference %08x\n", loop, beats,
+                                 rotate, actual, expected);
+                }
+                CHECK(actual == expected);
+            }
+        }
+    }
+}
+
+// Note-ons per lane over ticks [0, endTick).
+std::array<int, kMaxBeats> laneHits(BeatEngine& engine, int endTick) {
+    std::vector<BeatEvent> events;
+    runTicks(engine, 0, endTick, events);
+    std::array<int, kMaxBeats> hits{};
+    for (const BeatEvent& ev : events) {
+        if (ev.noteOn) ++hits[static_cast<size_t>(ev.beatIndex)];
+    }
+    return hits;
+}
+
+void testMuteAndSolo() {
+    const int lanes = std::min(kMaxBeats, 4);
+    auto make = [&] {
+        BeatEngine engine;
+        BeatParams p;
+        p.bars = 1;
+        p.loop = 4;
+        p.beats = 4;
+        p.loud = 100;
+        for (int lane = 0; lane < lanes; ++lane) {
+            p.noteIndex = lane;
+            setLane(engine, lane, p);
+        }
+        engine.seek(0);
+        return engine;
+    };
+    const int bar = 4 * kTicksPerQuarter;
+
+    BeatEngine open = make();
+    const auto all = laneHits(open, 2 * bar);
+    for (int lane = 0; lane < lanes; ++lane) CHECK(all[static_cast<size_t>(lane)] > 0);
+
+    BeatEngine muted = make();
+    muted.setLaneMute(0, true);
+    const auto m = laneHits(muted, 2 * bar);
+    CHECK(m[0] == 0);
+    for (int lane = 1; lane < lanes; ++lane) CHECK(m[static_cast<size_t>(lane)] == all[static_cast<size_t>(lane)]);
+
+    if (lanes > 2) {
+        BeatEngine solo = make();
+        solo.setLaneSolo(1, true);
+        solo.setLaneSolo(2, true);
+        solo.setLaneMute(2, true);  // mute wins over solo
+        const auto s = laneHits(solo, 2 * bar);
+        for (int lane = 0; lane < lanes; ++lane) {
+            CHECK(s[static_cast<size_t>(lane)] == (lane == 1 ? all[static_cast<size_t>(lane)] : 0));
+        }
+    }
+
+    BeatEngine global = make();
+    global.setMuted(true);
+    const auto g = laneHits(global, 2 * bar);
+    for (int lane = 0; lane < lanes; ++lane) CHECK(g[static_cast<size_t>(lane)] == 0);
+
+    // Muting a lane while it holds a note ends the note on the next tick.
+    BeatEngine held = make();
+    held.setLaneParam(0, kSlotGate, kMaxGate);
+    std::vector<BeatEvent> events;
+    int tick = 0;
+    while (std::none_of(events.begin(), events.end(), [](const BeatEvent& ev) { return ev.noteOn; })) {
+        runTicks(held, tick, tick + 1, events);
+        ++tick;
+    }
+    held.setLaneMute(0, true);
+    events.clear();
+    runTicks(held, tick, tick + 1, events);
+    const bool ended = std::any_of(events.begin(), events.end(),
+                                   [](const BeatEvent& ev) { return ev.beatIndex == 0 && !ev.noteOn; });
+    CHECK(ended);
+}
+
+// A pattern change mid-song keeps the lane on the song's grid: from the change
+// on it plays as if the new values had been set from the top. Rewriting the
+// values a lane already has changes nothing.
+void testPatternChangeKeepsPosition() {
+    auto make = [](int loop, int beats) {
+        BeatEngine engine;
+        for (int lane = 1; lane < kMaxBeats; ++lane) engine.setLaneMute(lane, true);
+        BeatParams p;
+        p.bars = 1;
+        p.loop = loop;
+        p.beats = beats;
+        p.loud = 100;
+        setLane(engine, 0, p);
+        engine.seek(0);
+        return engine;
+    };
+    auto noteOns = [](const std::vector<BeatEvent>& events) {
+        std::vector<int> ticks;
+        for (const BeatEvent& ev : events) {
+            if (ev.noteOn) ticks.push_back(ev.tick);
+        }
+        return ticks;
+    };
+    const int bar = 4 * kTicksPerQuarter;
+    const int change = bar + bar / 3 + 1;  // off the step grid of both patterns
+    const int end = change + 2 * bar;
+
+    BeatEngine changed = make(8, 3);
+    std::vector<BeatEvent> events;
+    runTicks(changed, 0, change, events);
+    changed.setLaneParam(0, kSlotLoop, 16);
+    changed.setLaneParam(0, kSlotBeats, 5);
+    events.clear();
+    runTicks(changed, change, end, events);
+
+    BeatEngine fromTop = make(16, 5);
+    fromTop.seek(change);
+    std::vector<BeatEvent> expected;
+    runTicks(fromTop, change, end, expected);
+    CHECK(!expected.empty());
+    CHECK(noteOns(events) == noteOns(expected));
+
+    BeatEngine rewritten = make(8, 3);
+    BeatEngine untouched = make(8, 3);
+    std::vector<BeatEvent> a;
+    std::vector<BeatEvent> b;
+    runTicks(rewritten, 0, change, a);
+    runTicks(untouched, 0, change, b);
+    BeatParams same;
+    same.bars = 1;
+    same.loop = 8;
+    same.beats = 3;
+    same.loud = 100;
+    setLane(rewritten, 0, same);
+    runTicks(rewritten, change, end, a);
+    runTicks(untouched, change, end, b);
+    CHECK(sameEvents(a, b));
+
+    // A loop shorter than its beats stays silent through rewrites.
+    BeatEngine unplayable = make(4, 6);
+    unplayable.setLaneParam(0, kSlotLoop, 4);
+    unplayable.setLaneParam(0, kSlotLoud, 100);
+    std::vector<BeatEvent> none;
+    runTicks(unplayable, 0, 2 * bar, none);
+    CHECK(noteOns(none).empty());
+}
+
+void testPurgeBalancesNotes() {
+    std::mt19937 rng(2);
+    for (int round = 0; round < 200; ++round) {
+        BeatEngine engine = randomEngine(rng);
+        std::vector<BeatEvent> events;
+        int tick = 0;
+        // Play, stop (purge), seek and play again a few times.
+        for (int stop = 0; stop < 4; ++stop) {
+            const int endTick = tick + 1 + static_cast<int>(rng() % 1500);
+            runRange(engine, tick, endTick, rng, events);
+            BeatEventSink sink;
+            engine.purgeAll(sink);
+            events.insert(events.end(), sink.begin(), sink.end());
+            CHECK(balanced(events));
+            // Nothing is left to end.
+            sink.clear();
+            engine.purgeAll(sink);
+            CHECK(sink.empty());
+            tick = endTick + static_cast<int>(rng() % 500);
+            engine.seek(tick);
+        }
+    }
+}
+
+void testNoteOffQueue() {
+    std::mt19937 rng(3);
+    NoteOffQueue queue;
+    std::array<int, kMaxBeats> pending;
+    pending.fill(-1);
+    for (int op = 0; op < 100000; ++op) {
+        const int lane = static_cast<int>(rng() % kMaxBeats);
+        switch (rng() % 4) {
+            case 0:
+            case 1: {
+                const int tick = static_cast<int>(rng() % 1000);
+                queue.schedule(lane, tick);
+                pending[static_cast<size_t>(lane)] = tick;
+                break;
+            }
+            case 2:
+                queue.cancel(lane);
+                pending[static_cast<size_t>(lane)] = -1;
+                break;
+            default:
+                if (queue.empty()) break;
+                // The top is the earliest pending note-off, one entry per lane.
+                const NoteOffQueue::Entry top = queue.top();
+                int earliest = -1;
+                for (int t : pending) {
+                    if (t >= 0 && (earliest < 0 || t < earliest)) earliest = t;
+                }
+                CHECK(top.tick == earliest);
+                CHECK(pending[static_cast<size_t>(top.lane)] == top.tick);
+                queue.pop();
+                pending[static_cast<size_t>(top.lane)] = -1;
+                break;
+        }
+        const bool anyPending = std::any_of(pending.begin(), pending.end(), [](int t) { return t >= 0; });
+        CHECK(queue.empty() == !anyPending);
+    }
+    queue.clear();
+    CHECK(queue.empty());
+}
+
+// Saved state values for a build with the given lane count, in BeatState.h's
+// order, as plain values.
+int stateValueCount(int lanes) {
+    return 2 + lanes * kStateLaneStride + 1 + lanes;
+}
+
+BeatParamRange stateRange(int index, int lanes) {
+    const int globalSolo = 2 + lanes * kStateLaneStride;
+    if (index == kStateBeatSelect) return {1, lanes};
+    if (index == kStateMuteAll || index == globalSolo) return {0, 1};
+    if (index > globalSolo) return kBeatParamRanges[kSlotGate];
+    const int slot = (index - 2) % kStateLaneStride;
+    return slot < kSlotGate ? kBeatParamRanges[slot] : BeatParamRange{0, 1};
+}
+
+// Where value index of a lanes-lane state lands in this build, -1 for nowhere.
+int stateIndexHere(int index, int lanes) {
+    const int globalSolo = 2 + lanes * kStateLaneStride;
+    if (index < 2) return index;
+    if (index == globalSolo) return kStateGlobalSolo;
+    if (index < globalSolo) {
+        const int lane = (index - 2) / kStateLaneStride;
+        return lane < kMaxBeats ? stateLaneIndex(lane, (index - 2) % kStateLaneStride) : -1;
+    }
+    const int lane = index - globalSolo - 1;
+    return lane < kMaxBeats ? stateGateIndex(lane) : -1;
+}
+
+double normalizedIn(int plain, BeatParamRange range) {
+    const int span = range.max - range.min;
+    return span > 0 ? static_cast<double>(std::clamp(plain, range.min, range.max) - range.min) / span : 0.0;
+}
+
+std::vector<int> randomStatePlains(std::mt19937& rng, int lanes) {
+    std::vector<int> plains;
+    for (int i = 0; i < stateValueCount(lanes); ++i) {
+        const BeatParamRange range = stateRange(i, lanes);
+        plains.push_back(range.min + static_cast<int>(rng() % static_cast<unsigned>(range.max - range.min + 1)));
+    }
+    return plains;
+}
+
+// The current format written out by hand: header, one or two bytes per value,
+// FNV-1a checksum.
+std::vector<uint8_t> encodeStateFor(const std::vector<int>& plains, int lanes, uint32_t version = kStateVersion) {
+    std::vector<uint8_t> out;
+    auto put = [&](uint32_t value, int bytes) {
+        for (int b = 0; b < bytes; ++b) out.push_back(static_cast<uint8_t>(value >> (8 * b)));
+    };
+    put(kStateMagic, 4);
+    put(version, 2);
+    put(static_cast<uint32_t>(lanes), 2);
+    for (int i = 0; i < stateValueCount(lanes); ++i) {
+        const BeatParamRange range = stateRange(i, lanes);
+        put(static_cast<uint32_t>(plains[static_cast<size_t>(i)] - range.min), range.max - range.min > 0xFF ? 2 : 1);
+    }
+    uint32_t hash = 2166136261u;
+    for (uint8_t byte : out) {
+        hash ^= byte;
+        hash *= 16777619u;
+    }
+    put(hash, 4);
+    return out;
+}
+
+// Decoded values as expected from a lanes-lane state, -1 where the state has
+// nothing for this build.
+std::vector<double> expectedState(const std::vector<int>& plains, int lanes) {
+    std::vector<double> values(static_cast<size_t>(kStateValueCount), -1.0);
+    for (int i = 0; i < stateValueCount(lanes); ++i) {
+        const int here = stateIndexHere(i, lanes);
+        if (here >= 0) values[static_cast<size_t>(here)] = normalizedIn(plains[static_cast<size_t>(i)], stateRange(here, kMaxBeats));
+    }
+    return values;
+}
+
+void testStateRoundTrip() {
+    std::mt19937 rng(8);
+    for (int round = 0; round < 100; ++round) {
+        const std::vector<int> plains = randomStatePlains(rng, kMaxBeats);
+        const std::vector<double> values = expectedState(plains, kMaxBeats);
+        const std::vector<uint8_t> bytes = encodeState(values.data());
+        CHECK(bytes == encodeStateFor(plains, kMaxBeats));
+        std::vector<double> decoded(values.size(), -1.0);
+        CHECK(decodeState(bytes.data(), bytes.size(), decoded.data()));
+        CHECK(decoded == values);
+    }
+}
+
+// States from builds with other lane counts load the lanes both builds have and
+// leave the rest as they were.
+void testStateFromOtherLaneCounts() {
+    std::mt19937 rng(9);
+    for (int lanes : {1, kMaxBeats - 1, kMaxBeats + 1, 64}) {
+        if (lanes < 1 || lanes > 64) continue;
+        for (int round = 0; round < 20; ++round) {
+            const std::vector<int> plains = randomStatePlains(rng, lanes);
+            const std::vector<uint8_t> bytes = encodeStateFor(plains, lanes);
+            std::vector<double> decoded(static_cast<size_t>(kStateValueCount), -1.0);
+            CHECK(decodeState(bytes.data(), bytes.size(), decoded.data()));
+            CHECK(decoded == expectedState(plains, lanes));
+        }
+    }
+}
+
+// The headerless stream of doubles from before the current format, always the
+// 8-lane layout, whole or without the Gate values added later.
+void testLegacyStateLoads() {
+    std::mt19937 rng(10);
+    constexpr int kLegacyLanes = 8;
+    for (int round = 0; round < 20; ++round) {
+        const std::vector<int> plains = randomStatePlains(rng, kLegacyLanes);
+        std::vector<uint8_t> bytes;
+        for (int i = 0; i < stateValueCount(kLegacyLanes); ++i) {
+            const double value = normalizedIn(plains[static_cast<size_t>(i)], stateRange(i, kLegacyLanes));
+            uint64_t bits = 0;
+            std::memcpy(&bits, &value, sizeof(double));
+            for (int b = 0; b < 8; ++b) bytes.push_back(static_cast<uint8_t>(bits >> (8 * b)));
+        }
+        std::vector<double> decoded(static_cast<size_t>(kStateValueCount), -1.0);
+        CHECK(decodeState(bytes.data(), bytes.size(), decoded.data()));
+        CHECK(decoded == expectedState(plains, kLegacyLanes));
+
+        const size_t withoutGates = static_cast<size_t>(2 + kLegacyLanes * kStateLaneStride + 1) * 8;
+        std::vector<double> expected = expectedState(plains, kLegacyLanes);
+        for (int lane = 0; lane < kMaxBeats; ++lane) expected[static_cast<size_t>(stateGateIndex(lane))] = -1.0;
+        std::fill(decoded.begin(), decoded.end(), -1.0);
+        CHECK(decodeState(bytes.data(), withoutGates, decoded.data()));
+        CHECK(decoded == expected);
+    }
+}
+
+// A damaged, cut short or newer state is refused and changes nothing.
+void testDamagedStateIsRejected() {
+    std::mt19937 rng(11);
+    const std::vector<int> plains = randomStatePlains(rng, kMaxBeats);
+    const std::vector<uint8_t> good = encodeStateFor(plains, kMaxBeats);
+    std::vector<std::vector<uint8_t>> bad;
+    for (size_t at = 4; at < good.size(); ++at) {
+        bad.push_back(good);
+        bad.back()[at] ^= 0x01;
+    }
+    bad.emplace_back(good.begin(), good.end() - 1);
+    bad.emplace_back(good.begin(), good.begin() + 8);
+    bad.push_back(good);
+    bad.back().push_back(0);
+    bad.push_back(encodeStateFor(plains, kMaxBeats, kStateVersion + 1));
+    bad.push_back(encodeStateFor(randomStatePlains(rng, 8), 0));
+    for (const std::vector<uint8_t>& bytes : bad) {
+        std::vector<double> decoded(static_cast<size_t>(kStateValueCount), -1.0);
+        CHECK(!decodeState(bytes.data(), bytes.size(), decoded.data()));
+        CHECK(std::all_of(decoded.begin(), decoded.end(), [](double v) { return v == -1.0; }));
+    }
+}
+
+// processTick, processRange, purgeAll, seeks, the pattern rebuilds after
+// parameter changes and note-off churn make no heap allocation.
+void testAudioPathDoesNotAllocate() {
+    std::mt19937 rng(4);
+    BeatEngine engine = randomEngine(rng);
+    std::array<BeatParams, 64> changes;
+    for (BeatParams& p : changes) p = randomLane(rng);
+    BeatEventSink sink;
+    NoteOffQueue queue;
+    long events = 0;
+
+    const long before = allocationCount;
+    for (int tick = 0; tick < 20000; ++tick) {
+        sink.clear();
+        engine.processTick(tick, sink);
+        events += sink.size();
+        if (tick % 997 == 0) setLane(engine, tick % kMaxBeats, changes[static_cast<size_t>(tick % 64)]);
+        if (tick % 1499 == 0) {
+            sink.clear();
+            engine.purgeAll(sink);
+        }
+    }
+    for (int tick = 20000; tick < 200000;) {
+        sink.clear();
+        tick = engine.processRange(tick, std::min(200000, tick + 1 + static_cast<int>(rng() % 500)), sink);
+        events += sink.size();
+        if (rng() % 50 == 0) {
+            sink.clear();
+            engine.purgeAll(sink);
+            engine.seek(tick);
+        }
+    }
+    for (int op = 0; op < 100000; ++op) {
+        const int lane = static_cast<int>(rng() % kMaxBeats);
+        if (rng() % 3 != 0) {
+            queue.schedule(lane, static_cast<int>(rng() % 1000));
+        } else if (!queue.empty()) {
+            queue.pop();
+        }
+    }
+    queue.clear();
+    const long allocations = allocationCount - before;
+
+    CHECK(events > 0);
+    CHECK(allocations == 0);
+}
+
+} // namespace
+
+int main() {
+    testProcessRangeMatchesTicks();
+    testSkipMatchesTicks();
+    testEventsInRangeMatchesProcessRange();
+    testKnownPatterns();
+    testPatternTableMatchesReference();
+    testMuteAndSolo();
+    testPatternChangeKeepsPosition();
+    testPurgeBalancesNotes();
+    testNoteOffQueue();
+    testStateRoundTrip();
+    testStateFromOtherLaneCounts();
+    testLegacyStateLoads();
+    testDamagedStateIsRejected();
+    testAudioPathDoesNotAllocate();
+    if (failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("beat_engine_tests: all checks passed\n");
+    return 0;
+}
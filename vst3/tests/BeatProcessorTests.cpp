@@ -0,0 +1,183 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+//
+// BeatProcessor tests against the real process() entry point, with the SDK's
+// hosting EventList and ParameterChanges standing in for a DAW. Plain checks
+// with no framework: each failure prints its location and the run exits
+// non-zero.
+//
+//   beat_processor_tests
+#include "BeatProcessor.h"
+
+#include "public.sdk/source/vst/hosting/eventlist.h"
+#include "public.sdk/source/vst/hosting/parameterchanges.h"
+
+#include <cmath>
+#include <cstdio>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace Steinberg;
+using namespace Steinberg::Vst;
+using namespace beatvst;
+
+namespace {
+
+int failures = 0;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            ++failures;                                                             \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        }                                                                           \
+    } while (0)
+
+constexpr double kSampleRate = 48000.0;
+constexpr double kTempo = 120.0;
+constexpr int32 kBlockSize = 512;
+
+// Note-ons as (24 PPQ tick, pitch), so runs that start differently compare by
+// song position.
+using NoteOns = std::multiset<std::pair<long long, int>>;
+
+ParamValue plainToNormalized(BeatParamSlot slot, int plain) {
+    const BeatParamRange& range = kBeatParamRanges[slot];
+    return static_cast<ParamValue>(plain - range.min) / static_cast<ParamValue>(range.max - range.min);
+}
+
+void addPoint(ParameterChanges& changes, BeatParamSlot slot, int32 offset, int plain) {
+    int32 queueIndex = 0;
+    IParamValueQueue* queue = changes.addParameterData(beatParamId(0, slot), queueIndex);
+    if (!queue) return;
+    int32 pointIndex = 0;
+    queue->addPoint(offset, plainToNormalized(slot, plain), pointIndex);
+}
+
+// Sets up lane 1 in a stopped block, then plays leadBlocks blocks from the top
+// (none for a start mid-song) and 600 more from startQuarter. changes is added
+// to the first block at startQuarter. Returns the note-ons from startQuarter.
+template <typename Changes>
+NoteOns play(int setupLoop, int leadBlocks, double startQuarter, Changes changes) {
+    BeatProcessor processor;
+    processor.initialize(nullptr);
+    ProcessSetup setup{};
+    setup.processMode = kRealtime;
+    setup.symbolicSampleSize = kSample32;
+    setup.maxSamplesPerBlock = kBlockSize;
+    setup.sampleRate = kSampleRate;
+    processor.setupProcessing(setup);
+    processor.setActive(true);
+    processor.setProcessing(true);
+
+    std::vector<float> left(static_cast<size_t>(kBlockSize));
+    std::vector<float> right(static_cast<size_t>(kBlockSize));
+    float* channels[] = {left.data(), right.data()};
+    AudioBusBuffers output{};
+    output.numChannels = 2;
+    output.channelBuffers32 = channels;
+
+    EventList outEvents(1024);
+    ParameterChanges inChanges(kParamCount);
+    ProcessContext context{};
+    context.sampleRate = kSampleRate;
+    context.tempo = kTempo;
+    context.timeSigNumerator = 4;
+    context.timeSigDenominator = 4;
+
+    ProcessData data{};
+    data.processMode = kRealtime;
+    data.symbolicSampleSize = kSample32;
+    data.numSamples = kBlockSize;
+    data.numOutputs = 1;
+    data.outputs = &output;
+    data.inputParameterChanges = &inChanges;
+    data.outputEvents = &outEvents;
+    data.processContext = &context;
+
+    context.state = ProcessContext::kTempoValid | ProcessContext::kProjectTimeMusicValid | ProcessContext::kTimeSigValid;
+    addPoint(inChanges, kSlotBars, 0, 1);
+    addPoint(inChanges, kSlotLoop, 0, setupLoop);
+    addPoint(inChanges, kSlotBeats, 0, 5);
+    addPoint(inChanges, kSlotLoud, 0, 100);
+    processor.process(data);
+
+    const double samplesPerQuarter = kSampleRate * 60.0 / kTempo;
+    context.state |= ProcessContext::kPlaying;
+    NoteOns notes;
+    double quarter = 0.0;
+    for (int block = 0; block < leadBlocks + 600; ++block) {
+        inChanges.clearQueue();
+        if (block == leadBlocks) {
+            quarter = startQuarter;
+            changes(inChanges);
+        }
+        outEvents.clear();
+        context.projectTimeMusic = quarter;
+        processor.process(data);
+        for (int32 i = 0; i < outEvents.getEventCount() && block >= leadBlocks; ++i) {
+            Event e{};
+            outEvents.getEvent(i, e);
+            if (e.type != Event::kNoteOnEvent) continue;
+            const double at = quarter + e.sampleOffset / samplesPerQuarter;
+            notes.insert({std::llround(at * 24.0), e.noteOn.pitch});
+        }
+        quarter += kBlockSize / samplesPerQuarter;
+    }
+    processor.setProcessing(false);
+    processor.setActive(false);
+    processor.terminate();
+    return notes;
+}
+
+// A pattern change at the first sample of a start or a jump is in effect when
+// the lanes are located to the song position: it plays the same notes as the
+// same values set before playback.
+void testFirstSampleChangeAppliesBeforeLocate() {
+    const double position = 37.3;  // mid-song, off the step grid
+    const auto none = [](ParameterChanges&) {};
+    const auto change = [](ParameterChanges& changes) { addPoint(changes, kSlotLoop, 0, 7); };
+
+    const NoteOns started = play(7, 0, position, none);
+    CHECK(!started.empty());
+    CHECK(play(16, 0, position, change) == started);
+
+    // A jump to the same position after playing from the top for 40 blocks.
+    const NoteOns jumped = play(7, 40, position, none);
+    CHECK(!jumped.empty());
+    CHECK(play(16, 40, position, change) == jumped);
+}
+
+// More parameter points than the processor buffers in one block still end on
+// each queue's final value, whether the queue is thinned or, once the buffer
+// is full, only its final value is kept.
+void testParamPointOverflowKeepsFinalValues() {
+    const double position = 37.3;
+    const NoteOns expected = play(7, 0, position, [](ParameterChanges&) {});
+    // Loop steps through every length and ends on 7.
+    const auto denseLoop = [](ParameterChanges& changes) {
+        for (int i = 0; i < 300; ++i) addPoint(changes, kSlotLoop, 0, 1 + (i + 11) % 16);
+    };
+    CHECK(play(16, 0, position, denseLoop) == expected);
+    // Queues that fit whole leave too little room to thin Loop's.
+    const auto fullFirst = [&](ParameterChanges& changes) {
+        for (int i = 0; i < 100; ++i) addPoint(changes, kSlotBeats, 0, 5);
+        for (int i = 0; i < 20; ++i) addPoint(changes, kSlotLoud, 0, 100);
+        denseLoop(changes);
+    };
+    CHECK(play(16, 0, position, fullFirst) == expected);
+}
+
+} // namespace
+
+int main() {
+    testFirstSampleChangeAppliesBeforeLocate();
+    testParamPointOverflowKeepsFinalValues();
+    if (failures != 0) {
+        std::fprintf(stderr, "%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("beat_processor_tests: all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,185 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+//
+// Per-tick engine benchmark. Times BeatEngine::processTick, which counts down
+// every lane's clock in one pass over the structure-of-arrays state, against
+// the loop it replaced: one branchy tick() call per lane, each lane holding its
+// own clock. Both run the same lanes one tick at a time; the range column runs
+// the batched engine through processRange, which skips ticks where nothing is
+// due. Prints one CSV row per active lane count (speedups over per-lane):
+//
+//   lanes,ticks,per_lane_ns,batched_ns,range_ns,batched_speedup,range_speedup
+//
+//   beat_engine_bench [--ticks N]
+#include "BeatEngine.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace beatvst;
+
+namespace {
+
+// The per-lane tick() loop BeatEngine::processTick used before its lane clocks
+// moved to structure-of-arrays, with note-offs per lane instead of a queue.
+class PerLaneEngine {
+public:
+    void setLane(int lane, const BeatParams& p) {
+        Lane& l = lanes_[static_cast<size_t>(lane)];
+        l = Lane{};
+        l.index = lane;
+        l.params = p;
+        l.note = noteIndexToMidi(p.octave, p.noteIndex);
+        l.sustainTicks = std::max(1, p.gate * kTicksPerQuarter / kGateTicksPerQuarter);
+        l.mute = p.beats == 0 || p.loud == 0 || p.loop < p.beats;
+        l.length = std::clamp(p.loop, 0, kMaxLoopLength);
+        l.pattern = rotatePattern(euclideanPattern(l.length, p.beats), l.length, p.rotate);
+        l.stepTicks = std::max(1, static_cast<int>(std::round(p.bars * 4 * kTicksPerQuarter / static_cast<double>(p.loop))));
+    }
+
+    void processTick(int globalTick, BeatEventSink& out) {
+        out.setTick(globalTick);
+        for (Lane& l : lanes_) tick(l, globalTick, out);
+    }
+
+private:
+    struct Lane {
+        int index{0};
+        BeatParams params{};
+        uint32_t pattern{0};
+        int length{0};
+        int step{0};
+        int countdown{0};
+        int stepTicks{1};
+        int sustainTicks{1};
+        int offTick{0};
+        bool updateNotes{true};
+        bool updatePattern{true};  // the first tick rebuilds the pattern and waits a step
+        bool mute{true};
+        bool externalMute{false};
+        bool muted{false};
+        uint8_t note{60};
+    };
+
+    static void tick(Lane& l, int globalTick, BeatEventSink& out) {
+        if (l.updateNotes) l.updateNotes = false;
+        if (l.updatePattern) {
+            l.updatePattern = false;
+            l.countdown = l.stepTicks;
+            return;
+        }
+        if (l.mute || l.externalMute) {
+            if (!l.muted) {
+                l.muted = true;
+                if (l.offTick != 0) out.push(BeatEvent{l.index, l.note, 0, false});
+                l.offTick = 0;
+            }
+            return;
+        }
+        if (l.offTick != 0 && globalTick >= l.offTick) {
+            out.push(BeatEvent{l.index, l.note, 0, false});
+            l.offTick = 0;
+        }
+        l.countdown -= 1;
+        if (l.countdown > 0) return;
+        l.countdown = l.stepTicks;
+        if (l.length > 0 && ((l.pattern >> l.step) & 1u) != 0) {
+            if (l.offTick != 0) out.push(BeatEvent{l.index, l.note, 0, false});
+            out.push(BeatEvent{l.index, l.note, static_cast<uint8_t>(l.params.loud), true});
+            l.offTick = globalTick + l.sustainTicks;
+        }
+        if (++l.step >= l.length) l.step = 0;
+    }
+
+    std::array<Lane, kMaxBeats> lanes_{};
+};
+
+// Lanes below active play assorted patterns; the rest are silent.
+BeatParams laneParams(int lane, int active) {
+    BeatParams p;
+    p.bars = 1;
+    p.loop = 16 - lane % 8;
+    p.beats = 3 + lane % 5;
+    p.rotate = lane % 3;
+    p.noteIndex = lane % 12;
+    p.octave = 2 + (lane / 12) % 4;
+    p.loud = lane < active ? 100 : 0;
+    return p;
+}
+
+template <typename Engine>
+double nsPerTick(Engine& engine, int ticks, long& events) {
+    BeatEventSink sink;
+    const auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks; ++tick) {
+        sink.clear();
+        engine.processTick(tick, sink);
+        events += sink.size();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / ticks;
+}
+
+double rangeNsPerTick(BeatEngine& engine, int ticks, long& events) {
+    BeatEventSink sink;
+    const auto start = std::chrono::steady_clock::now();
+    for (int tick = 0; tick < ticks;) {
+        sink.clear();
+        tick = engine.processRange(tick, ticks, sink);
+        events += sink.size();
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / ticks;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int ticks = 2000000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            ticks = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "usage: beat_engine_bench [--ticks N]\n");
+            return 1;
+        }
+    }
+
+    std::printf("lanes,ticks,per_lane_ns,batched_ns,range_ns,batched_speedup,range_speedup\n");
+    const int counts[] = {1, 4, 8, 16, 32, 64};
+    for (int active : counts) {
+        if (active > kMaxBeats) break;
+        PerLaneEngine perLane;
+        BeatEngine batched;
+        BeatEngine ranged;
+        for (int lane = 0; lane < kMaxBeats; ++lane) {
+            const BeatParams p = laneParams(lane, active);
+            perLane.setLane(lane, p);
+            for (BeatEngine* engine : {&batched, &ranged}) {
+                engine->setLaneParam(lane, kSlotBars, p.bars);
+                engine->setLaneParam(lane, kSlotLoop, p.loop);
+                engine->setLaneParam(lane, kSlotBeats, p.beats);
+                engine->setLaneParam(lane, kSlotRotate, p.rotate);
+                engine->setLaneParam(lane, kSlotNoteIndex, p.noteIndex);
+                engine->setLaneParam(lane, kSlotOctave, p.octave);
+                engine->setLaneParam(lane, kSlotLoud, p.loud);
+                engine->setLaneParam(lane, kSlotGate, p.gate);
+            }
+        }
+        batched.seek(0);
+        ranged.seek(0);
+        long events = 0;
+        const double perLaneNs = nsPerTick(perLane, ticks, events);
+        const double batchedNs = nsPerTick(batched, ticks, events);
+        const double rangeNs = rangeNsPerTick(ranged, ticks, events);
+        std::printf("%d,%d,%.2f,%.2f,%.2f,%.2f,%.2f\n", active, ticks, perLaneNs, batchedNs, rangeNs,
+                    batchedNs > 0.0 ? perLaneNs / batchedNs : 0.0, rangeNs > 0.0 ? perLaneNs / rangeNs : 0.0);
+        if (events < 0) return 1;  // keeps the rendered events observable
+    }
+    return 0;
+}
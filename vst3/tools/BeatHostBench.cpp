@@ -0,0 +1,202 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+//
+// Host-emulation benchmark for BeatProcessor::process. Stands in for a DAW by
+// supplying ProcessData, ProcessContext, an output IEventList and input/output
+// IParameterChanges, then sweeps block size, sample rate, tempo, active lane
+// count and automation density. Prints one CSV row per configuration:
+//
+//   block,rate,tempo,lanes,points,ns_per_block,events_per_s,worst_block_ns
+//
+//   beat_host_bench [--quick] [--seconds S]
+#include "BeatProcessor.h"
+
+#include "public.sdk/source/vst/hosting/eventlist.h"
+#include "public.sdk/source/vst/hosting/parameterchanges.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Steinberg;
+using namespace Steinberg::Vst;
+using namespace beatvst;
+
+namespace {
+
+struct BenchConfig {
+    int32 blockSize;
+    double sampleRate;
+    double tempo;
+    int activeLanes;
+    int pointsPerBlock;
+};
+
+struct BenchResult {
+    double nsPerBlock{0.0};
+    double eventsPerSecond{0.0};
+    double worstBlockNs{0.0};
+};
+
+ParamValue plainToNormalized(BeatParamSlot slot, int plain) {
+    const BeatParamRange& range = kBeatParamRanges[slot];
+    return static_cast<ParamValue>(plain - range.min) / static_cast<ParamValue>(range.max - range.min);
+}
+
+void addPoint(ParameterChanges& changes, ParamID pid, int32 offset, ParamValue value) {
+    int32 queueIndex = 0;
+    IParamValueQueue* queue = changes.addParameterData(pid, queueIndex);
+    if (!queue) return;
+    int32 pointIndex = 0;
+    queue->addPoint(offset, value, pointIndex);
+}
+
+BenchResult runConfig(const BenchConfig& config, double seconds) {
+    auto* processor = new BeatProcessor();
+    processor->initialize(nullptr);
+
+    ProcessSetup setup{};
+    setup.processMode = kRealtime;
+    setup.symbolicSampleSize = kSample32;
+    setup.maxSamplesPerBlock = config.blockSize;
+    setup.sampleRate = config.sampleRate;
+    processor->setupProcessing(setup);
+    processor->setActive(true);
+    processor->setProcessing(true);
+
+    std::vector<float> left(static_cast<size_t>(config.blockSize));
+    std::vector<float> right(static_cast<size_t>(config.blockSize));
+    float* channels[] = {left.data(), right.data()};
+    AudioBusBuffers output{};
+    output.numChannels = 2;
+    output.channelBuffers32 = channels;
+
+    EventList outEvents(16384);
+    ParameterChanges inChanges(kActiveParamBase + kPerBeatParams);
+    ParameterChanges outChanges(kParamGlobalSolo + 1);
+
+    ProcessContext context{};
+    context.state = ProcessContext::kPlaying | ProcessContext::kTempoValid | ProcessContext::kProjectTimeMusicValid |
+                    ProcessContext::kTimeSigValid;
+    context.sampleRate = config.sampleRate;
+    context.tempo = config.tempo;
+    context.timeSigNumerator = 4;
+    context.timeSigDenominator = 4;
+
+    ProcessData data{};
+    data.processMode = kRealtime;
+    data.symbolicSampleSize = kSample32;
+    data.numOutputs = 1;
+    data.outputs = &output;
+    data.inputParameterChanges = &inChanges;
+    data.outputParameterChanges = &outChanges;
+    data.outputEvents = &outEvents;
+    data.processContext = &context;
+
+    // Lane setup arrives as ordinary parameter changes in the first block.
+    for (int lane = 0; lane < kMaxBeats; ++lane) {
+        const bool active = lane < config.activeLanes;
+        addPoint(inChanges, beatParamId(lane, kSlotLoud), 0, plainToNormalized(kSlotLoud, active ? 100 : 0));
+        const int loop = 12 + lane % (kMaxLoopLength - 11);
+        addPoint(inChanges, beatParamId(lane, kSlotLoop), 0, plainToNormalized(kSlotLoop, loop));
+        addPoint(inChanges, beatParamId(lane, kSlotBeats), 0, plainToNormalized(kSlotBeats, 3 + lane % 9));
+    }
+
+    std::mt19937 rng(1234);
+    const BeatParamSlot automated[] = {kSlotBeats, kSlotRotate, kSlotLoud};
+    const int64 totalSamples = static_cast<int64>(seconds * config.sampleRate);
+    const double quartersPerSample = config.tempo / (60.0 * config.sampleRate);
+    int64 blocks = 0;
+    int64 events = 0;
+    double totalNs = 0.0;
+    double worstNs = 0.0;
+
+    for (int64 pos = 0; pos < totalSamples; pos += config.blockSize) {
+        if (blocks > 0) {
+            inChanges.clearQueue();
+            for (int p = 0; p < config.pointsPerBlock; ++p) {
+                const int lane = static_cast<int>(rng() % static_cast<uint32>(std::max(1, config.activeLanes)));
+                const BeatParamSlot slot = automated[rng() % 3];
+                const BeatParamRange& range = kBeatParamRanges[slot];
+                const int plain = slot == kSlotLoud ? 64 + static_cast<int>(rng() % 64)
+                                                    : range.min + static_cast<int>(rng() % 16);
+                addPoint(inChanges, beatParamId(lane, slot), static_cast<int32>(rng() % static_cast<uint32>(config.blockSize)),
+                         plainToNormalized(slot, plain));
+            }
+        }
+        outEvents.clear();
+        outChanges.clearQueue();
+        data.numSamples = config.blockSize;
+        context.projectTimeSamples = pos;
+        context.projectTimeMusic = static_cast<double>(pos) * quartersPerSample;
+
+        const auto start = std::chrono::steady_clock::now();
+        processor->process(data);
+        const auto stop = std::chrono::steady_clock::now();
+
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        totalNs += ns;
+        worstNs = std::max(worstNs, ns);
+        events += outEvents.getEventCount();
+        ++blocks;
+    }
+
+    processor->setProcessing(false);
+    processor->setActive(false);
+    processor->terminate();
+    processor->release();
+
+    BenchResult result;
+    if (blocks > 0) result.nsPerBlock = totalNs / static_cast<double>(blocks);
+    if (totalNs > 0.0) result.eventsPerSecond = static_cast<double>(events) / (totalNs * 1e-9);
+    result.worstBlockNs = worstNs;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    double seconds = 2.0;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--quick") == 0) {
+            quick = true;
+        } else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = std::max(0.01, std::atof(argv[++i]));
+        } else {
+            std::fprintf(stderr, "usage: beat_host_bench [--quick] [--seconds S]\n");
+            return 1;
+        }
+    }
+
+    const std::vector<int32> blockSizes = quick ? std::vector<int32>{1, 64, 8192}
+                                                : std::vector<int32>{1, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192};
+    const std::vector<double> sampleRates = quick ? std::vector<double>{48000.0}
+                                                  : std::vector<double>{44100.0, 48000.0, 96000.0, 192000.0};
+    const std::vector<double> tempos = quick ? std::vector<double>{120.0, 999.0}
+                                             : std::vector<double>{20.0, 60.0, 120.0, 240.0, 500.0, 999.0};
+    const std::vector<int> laneCounts = quick ? std::vector<int>{kMaxBeats} : std::vector<int>{0, 1, kMaxBeats / 2, kMaxBeats};
+    const std::vector<int> pointCounts = quick ? std::vector<int>{0, 8} : std::vector<int>{0, 1, 8, 64};
+
+    std::printf("block,rate,tempo,lanes,points,ns_per_block,events_per_s,worst_block_ns\n");
+    for (int32 block : blockSizes) {
+        for (double rate : sampleRates) {
+            for (double tempo : tempos) {
+                for (int lanes : laneCounts) {
+                    for (int points : pointCounts) {
+                        const BenchConfig config{block, rate, tempo, lanes, points};
+                        const BenchResult r = runConfig(config, seconds);
+                        std::printf("%d,%.0f,%.0f,%d,%d,%.1f,%.0f,%.0f\n", block, rate, tempo, lanes, points, r.nsPerBlock,
+                                    r.eventsPerSecond, r.worstBlockNs);
+                        std::fflush(stdout);
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+//
+// Instantiation benchmark. Creates and initializes many processors, then many
+// controllers, the way a host loading a large template does, and reports the
+// time and resident memory each instance costs. Prints one CSV row per side:
+//
+//   side,instances,ns_per_instance,bytes_per_instance,object_bytes
+//
+//   beat_instance_bench [--instances N]
+#include "BeatController.h"
+#include "BeatProcessor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace Steinberg;
+using namespace beatvst;
+
+namespace {
+
+// Resident set size of this process in bytes, 0 when unavailable.
+size_t residentBytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+    return counters.WorkingSetSize;
+#elif defined(__APPLE__)
+    mach_task_basic_info info{};
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS)
+        return 0;
+    return info.resident_size;
+#else
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    long pages = 0;
+    long resident = 0;
+    const int fields = std::fscanf(f, "%ld %ld", &pages, &resident);
+    std::fclose(f);
+    return fields == 2 ? static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#endif
+}
+
+struct InstanceResult {
+    double nsPerInstance{0.0};
+    double bytesPerInstance{0.0};
+};
+
+// Creates and initializes count instances of T, keeping them all alive until
+// the measurement is taken so the resident delta covers every one.
+template <typename T>
+InstanceResult timeInstances(int count) {
+    std::vector<T*> instances;
+    instances.reserve(static_cast<size_t>(count));
+    const size_t before = residentBytes();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i) {
+        auto* instance = new T();
+        instance->initialize(nullptr);
+        instances.push_back(instance);
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const size_t after = residentBytes();
+
+    InstanceResult result;
+    result.nsPerInstance = std::chrono::duration<double, std::nano>(stop - start).count() / count;
+    result.bytesPerInstance = after > before ? static_cast<double>(after - before) / count : 0.0;
+    for (T* instance : instances) {
+        instance->terminate();
+        instance->release();
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int instanceCount = 500;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+            instanceCount = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "usage: beat_instance_bench [--instances N]\n");
+            return 1;
+        }
+    }
+
+    std::printf("side,instances,ns_per_instance,bytes_per_instance,object_bytes\n");
+    const InstanceResult processor = timeInstances<BeatProcessor>(instanceCount);
+    std::printf("processor,%d,%.0f,%.0f,%zu\n", instanceCount, processor.nsPerInstance, processor.bytesPerInstance,
+                sizeof(BeatProcessor));
+    const InstanceResult controller = timeInstances<BeatController>(instanceCount);
+    std::printf("controller,%d,%.0f,%.0f,%zu\n", instanceCount, controller.nsPerInstance, controller.bytesPerInstance,
+                sizeof(BeatController));
+    return 0;
+}
@@ -0,0 +1,231 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+//
+// Offline renderer: drives BeatEngine without a host clock and writes the
+// resulting note stream to a Standard MIDI File (format 0, one track).
+//
+//   beat_render [--state FILE] [--lane N:BARS,LOOP,BEATS,ROTATE,NOTE,OCTAVE,LOUD[,GATE]]...
+//               [--tempo BPM] [--meter NUM/DEN] [--bars N] -o OUT.mid
+//
+// Events land on the same ticks BeatProcessor::process() emits them when
+// playback starts at the top of the song, including the note-off purge on stop.
+#include "BeatEngine.h"
+#include "BeatState.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace beatvst;
+
+namespace {
+
+struct RenderSettings {
+    double tempo{120.0};
+    int meterNum{4};
+    int meterDen{4};
+    int bars{4};
+    std::string outPath;
+};
+
+void printUsage() {
+    std::fprintf(stderr,
+                 "usage: beat_render [--state FILE] [--lane N:BARS,LOOP,BEATS,ROTATE,NOTE,OCTAVE,LOUD[,GATE]]...\n"
+                 "                   [--tempo BPM] [--meter NUM/DEN] [--bars N] -o OUT.mid\n");
+}
+
+int normToInt(double norm, int min, int max) {
+    double v = min + norm * (max - min);
+    v = std::clamp(v, static_cast<double>(min), static_cast<double>(max));
+    return static_cast<int>(std::round(v));
+}
+
+bool loadState(const char* path, BeatEngine& engine) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    // Values the state does not hold stay NaN and keep the engine default.
+    std::array<double, kStateValueCount> values;
+    values.fill(std::nan(""));
+    if (!decodeState(bytes.data(), bytes.size(), values.data())) return false;
+    // Every state format has at least the lane blocks and Global Solo.
+    if (std::isnan(values[kStateGlobalSolo])) return false;
+
+    auto value = [&](int index) { return values[static_cast<size_t>(index)]; };
+    engine.setMuted(value(kStateMuteAll) > 0.5);
+    for (int lane = 0; lane < kMaxBeats; ++lane) {
+        for (int slot = 0; slot < kBeatParamSlotCount; ++slot) {
+            const double v = value(slot == kSlotGate ? stateGateIndex(lane) : stateLaneIndex(lane, slot));
+            if (std::isnan(v)) continue;
+            const BeatParamRange& range = kBeatParamRanges[slot];
+            engine.setLaneParam(lane, static_cast<BeatParamSlot>(slot), normToInt(v, range.min, range.max));
+        }
+        engine.setLaneMute(lane, value(stateLaneIndex(lane, kStateLaneMute)) > 0.5);
+        engine.setLaneSolo(lane, value(stateLaneIndex(lane, kStateLaneSolo)) > 0.5);
+    }
+    return true;
+}
+
+bool parseLane(const char* spec, BeatEngine& engine) {
+    int lane = 0;
+    int v[kBeatParamSlotCount]{};
+    v[kSlotGate] = kDefaultGate;
+    // Slot order on the command line follows the UI: Bars, Loop, Beats, Rotate, Note, Octave, Loud, then an optional Gate.
+    const int fields = std::sscanf(spec, "%d:%d,%d,%d,%d,%d,%d,%d,%d", &lane, &v[kSlotBars], &v[kSlotLoop], &v[kSlotBeats],
+                                   &v[kSlotRotate], &v[kSlotNoteIndex], &v[kSlotOctave], &v[kSlotLoud], &v[kSlotGate]);
+    if (fields != 8 && fields != 9) return false;
+    if (lane < 1 || lane > kMaxBeats) return false;
+    for (int slot = 0; slot < kBeatParamSlotCount; ++slot) {
+        const BeatParamRange& range = kBeatParamRanges[slot];
+        engine.setLaneParam(lane - 1, static_cast<BeatParamSlot>(slot), std::clamp(v[slot], range.min, range.max));
+    }
+    return true;
+}
+
+class MidiTrackWriter {
+public:
+    void reserve(size_t bytes) { data_.reserve(bytes); }
+
+    void meta(int64_t tick, uint8_t type, const uint8_t* payload, uint8_t size) {
+        delta(tick);
+        data_.push_back(0xFF);
+        data_.push_back(type);
+        data_.push_back(size);
+        data_.insert(data_.end(), payload, payload + size);
+    }
+
+    void note(int64_t tick, const BeatEvent& ev) {
+        delta(tick);
+        data_.push_back(ev.noteOn ? 0x90 : 0x80);
+        data_.push_back(ev.note & 0x7F);
+        data_.push_back(ev.noteOn ? static_cast<uint8_t>(ev.velocity & 0x7F) : 0);
+    }
+
+    bool save(const std::string& path) {
+        const uint8_t endOfTrack[] = {0x00, 0xFF, 0x2F, 0x00};
+        data_.insert(data_.end(), endOfTrack, endOfTrack + sizeof(endOfTrack));
+
+        std::ofstream out(path, std::ios::binary);
+        if (!out) return false;
+        const uint8_t header[] = {
+            'M', 'T', 'h', 'd', 0, 0, 0, 6,
+            0, 0,  // format 0
+            0, 1,  // one track
+            static_cast<uint8_t>((kTicksPerQuarter >> 8) & 0x7F), static_cast<uint8_t>(kTicksPerQuarter & 0xFF),
+            'M', 'T', 'r', 'k',
+            static_cast<uint8_t>(data_.size() >> 24), static_cast<uint8_t>(data_.size() >> 16),
+            static_cast<uint8_t>(data_.size() >> 8), static_cast<uint8_t>(data_.size()),
+        };
+        out.write(reinterpret_cast<const char*>(header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(data_.data()), static_cast<std::streamsize>(data_.size()));
+        return static_cast<bool>(out);
+    }
+
+private:
+    void delta(int64_t tick) {
+        uint64_t value = static_cast<uint64_t>(std::max<int64_t>(0, tick - lastTick_));
+        lastTick_ = std::max(lastTick_, tick);
+        uint8_t buffer[10];
+        int n = 0;
+        buffer[n++] = static_cast<uint8_t>(value & 0x7F);
+        while ((value >>= 7) != 0) buffer[n++] = static_cast<uint8_t>(0x80 | (value & 0x7F));
+        while (n > 0) data_.push_back(buffer[--n]);
+    }
+
+    std::vector<uint8_t> data_;
+    int64_t lastTick_{0};
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BeatEngine engine;
+    RenderSettings settings;
+
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (!value) {
+            printUsage();
+            return 1;
+        }
+        if (std::strcmp(arg, "--state") == 0) {
+            if (!loadState(value, engine)) {
+                std::fprintf(stderr, "beat_render: cannot read state from %s\n", value);
+                return 1;
+            }
+        } else if (std::strcmp(arg, "--lane") == 0) {
+            if (!parseLane(value, engine)) {
+                std::fprintf(stderr, "beat_render: bad lane spec '%s'\n", value);
+                return 1;
+            }
+        } else if (std::strcmp(arg, "--tempo") == 0) {
+            settings.tempo = std::atof(value);
+        } else if (std::strcmp(arg, "--meter") == 0) {
+            if (std::sscanf(value, "%d/%d", &settings.meterNum, &settings.meterDen) != 2) {
+                printUsage();
+                return 1;
+            }
+        } else if (std::strcmp(arg, "--bars") == 0) {
+            settings.bars = std::atoi(value);
+        } else if (std::strcmp(arg, "-o") == 0) {
+            settings.outPath = value;
+        } else {
+            printUsage();
+            return 1;
+        }
+        ++i;
+    }
+    if (settings.outPath.empty() || settings.tempo <= 0.0 || settings.bars <= 0 || settings.meterNum <= 0 ||
+        settings.meterDen <= 0 || (settings.meterDen & (settings.meterDen - 1)) != 0) {
+        printUsage();
+        return 1;
+    }
+
+    const int64_t ticksPerBar = static_cast<int64_t>(settings.meterNum) * 4 * kTicksPerQuarter / settings.meterDen;
+    const int64_t endTick = ticksPerBar * settings.bars;
+    if (endTick > kNoPendingEvent) {
+        std::fprintf(stderr, "beat_render: %d bars exceed the engine tick range\n", settings.bars);
+        return 1;
+    }
+
+    MidiTrackWriter track;
+    track.reserve(static_cast<size_t>(std::min<int64_t>(endTick, 1 << 24)));
+
+    const uint32_t usPerQuarter = static_cast<uint32_t>(std::lround(60000000.0 / settings.tempo));
+    const uint8_t tempoMeta[] = {static_cast<uint8_t>(usPerQuarter >> 16), static_cast<uint8_t>(usPerQuarter >> 8),
+                                 static_cast<uint8_t>(usPerQuarter)};
+    track.meta(0, 0x51, tempoMeta, sizeof(tempoMeta));
+    uint8_t denPower = 0;
+    while ((1 << denPower) < settings.meterDen) ++denPower;
+    const uint8_t meterMeta[] = {static_cast<uint8_t>(settings.meterNum), denPower, 24, 8};
+    track.meta(0, 0x58, meterMeta, sizeof(meterMeta));
+
+    // Same sequence as a transport start in process(): seek, then run from tick 0.
+    engine.seek(0);
+    BeatEventSink events;
+    for (int tick = 0; tick < endTick;) {
+        events.clear();
+        tick = engine.processRange(tick, static_cast<int>(endTick), events);
+        for (const auto& ev : events) {
+            if (!ev.coalesced) track.note(ev.tick, ev);
+        }
+    }
+
+    // Transport stop.
+    events.clear();
+    engine.purgeAll(events);
+    for (const auto& ev : events) track.note(endTick, ev);
+
+    if (!track.save(settings.outPath)) {
+        std::fprintf(stderr, "beat_render: cannot write %s\n", settings.outPath.c_str());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2026 Brian R. Gunnison
+// MIT License
+//
+// State load benchmark. Builds thousands of random saved states in both the
+// original stream-of-doubles format and the current compact format, then times
+// BeatProcessor::setState over each set. Prints one CSV row per format:
+//
+//   format,states,bytes_per_state,ns_per_load,worst_load_ns
+//
+//   beat_state_bench [--states N]
+#include "BeatProcessor.h"
+#include "BeatState.h"
+
+#include "public.sdk/source/common/memorystream.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Steinberg;
+using namespace beatvst;
+
+namespace {
+
+// Plain range of each state value, for generating states a user could save.
+BeatParamRange valueRange(int index) {
+    if (index == kStateBeatSelect) return {1, kMaxBeats};
+    if (index >= stateGateIndex(0)) return kBeatParamRanges[kSlotGate];
+    if (index >= stateLaneIndex(0, 0) && index < kStateGlobalSolo) {
+        const int field = (index - stateLaneIndex(0, 0)) % kStateLaneStride;
+        if (field < kSlotGate) return kBeatParamRanges[field];
+    }
+    return {0, 1};
+}
+
+std::vector<uint8_t> legacyBytes(const std::array<double, kStateValueCount>& values) {
+    std::vector<uint8_t> bytes(values.size() * 8);
+    for (size_t i = 0; i < values.size(); ++i) {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &values[i], sizeof(bits));
+        for (size_t b = 0; b < 8; ++b) bytes[i * 8 + b] = static_cast<uint8_t>(bits >> (8 * b));
+    }
+    return bytes;
+}
+
+struct LoadResult {
+    double bytesPerState{0.0};
+    double nsPerLoad{0.0};
+    double worstLoadNs{0.0};
+};
+
+LoadResult timeLoads(BeatProcessor& processor, std::vector<std::vector<uint8_t>>& states) {
+    LoadResult result;
+    double totalNs = 0.0;
+    size_t totalBytes = 0;
+    for (auto& bytes : states) {
+        MemoryStream stream(bytes.data(), static_cast<TSize>(bytes.size()));
+        const auto start = std::chrono::steady_clock::now();
+        processor.setState(&stream);
+        const auto stop = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        totalNs += ns;
+        result.worstLoadNs = std::max(result.worstLoadNs, ns);
+        totalBytes += bytes.size();
+    }
+    if (!states.empty()) {
+        result.bytesPerState = static_cast<double>(totalBytes) / static_cast<double>(states.size());
+        result.nsPerLoad = totalNs / static_cast<double>(states.size());
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int stateCount = 5000;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--states") == 0 && i + 1 < argc) {
+            stateCount = std::max(1, std::atoi(argv[++i]));
+        } else {
+            std::fprintf(stderr, "usage: beat_state_bench [--states N]\n");
+            return 1;
+        }
+    }
+
+    std::mt19937 rng(1234);
+    std::vector<std::vector<uint8_t>> legacy;
+    std::vector<std::vector<uint8_t>> compact;
+    legacy.reserve(static_cast<size_t>(stateCount));
+    compact.reserve(static_cast<size_t>(stateCount));
+    for (int s = 0; s < stateCount; ++s) {
+        std::array<double, kStateValueCount> values{};
+        for (int i = 0; i < kStateValueCount; ++i) {
+            const BeatParamRange range = valueRange(i);
+            const int span = range.max - range.min;
+            values[static_cast<size_t>(i)] = span > 0 ? static_cast<double>(rng() % static_cast<uint32_t>(span + 1)) / span : 0.0;
+        }
+        legacy.push_back(legacyBytes(values));
+        compact.push_back(encodeState(values.data()));
+    }
+
+    auto* processor = new BeatProcessor();
+    processor->initialize(nullptr);
+
+    std::printf("format,states,bytes_per_state,ns_per_load,worst_load_ns\n");
+    const LoadResult legacyResult = timeLoads(*processor, legacy);
+    std::printf("legacy,%d,%.0f,%.1f,%.0f\n", stateCount, legacyResult.bytesPerState, legacyResult.nsPerLoad,
+                legacyResult.worstLoadNs);
+    const LoadResult compactResult = timeLoads(*processor, compact);
+    std::printf("v%d,%d,%.0f,%.1f,%.0f\n", kStateVersion, stateCount, compactResult.bytesPerState, compactResult.nsPerLoad,
+                compactResult.worstLoadNs);
+
+    processor->terminate();
+    processor->release();
+    return 0;
+}